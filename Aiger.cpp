@@ -0,0 +1,217 @@
+#include "Aiger.h"
+#include <stdexcept>
+#include <fstream>
+#include <algorithm>
+#include <unordered_map>
+
+using cxxsat::VarManager;
+using cxxsat::var_t;
+using cxxsat::gate_kind_t;
+using cxxsat::aiger_info_t;
+
+namespace {
+
+constexpr uint32_t NO_DEFINITION = UINT32_MAX;
+/// AIGER literals of the constants
+constexpr uint32_t AIG_FALSE = 0;
+constexpr uint32_t AIG_TRUE = 1;
+
+/// Gate defining a variable, the variable equals the gate output negated by \a neg
+struct definition_t {
+    gate_kind_t kind;
+    std::vector<var_t> ins;
+    bool neg;
+};
+
+/// And-inverter graph with structural hashing, numbered as in an AIGER file
+class AigBuilder {
+private:
+    uint32_t m_num_inputs;
+    /// Right-hand sides of every AND, the larger one first
+    std::vector<std::pair<uint32_t, uint32_t>> m_ands;
+    std::unordered_map<uint64_t, uint32_t> m_strash;
+public:
+    explicit AigBuilder(uint32_t num_inputs) : m_num_inputs(num_inputs) { }
+
+    const std::vector<std::pair<uint32_t, uint32_t>>& ands() const { return m_ands; }
+
+    uint32_t make_and(uint32_t x, uint32_t y)
+    {
+        if (x < y) std::swap(x, y);
+        if (y == AIG_FALSE) return AIG_FALSE;
+        if (y == AIG_TRUE) return x;
+        if (x == y) return x;
+        if (x == (y ^ 1)) return AIG_FALSE;
+        const uint64_t key = (static_cast<uint64_t>(x) << 32) | y;
+        const auto it = m_strash.find(key);
+        if (it != m_strash.end()) return it->second;
+        const uint32_t lhs = 2 * (m_num_inputs + static_cast<uint32_t>(m_ands.size()) + 1);
+        m_ands.emplace_back(x, y);
+        m_strash.emplace(key, lhs);
+        return lhs;
+    }
+    uint32_t make_or(uint32_t x, uint32_t y) { return make_and(x ^ 1, y ^ 1) ^ 1; }
+    uint32_t make_xor(uint32_t x, uint32_t y) { return make_or(make_and(x, y ^ 1), make_and(x ^ 1, y)); }
+    uint32_t make_mux(uint32_t s, uint32_t t, uint32_t e) { return make_or(make_and(s, t), make_and(s ^ 1, e)); }
+    uint32_t make_maj(uint32_t a, uint32_t b, uint32_t c) { return make_or(make_and(a, b), make_and(c, make_or(a, b))); }
+
+    /// Balanced tree of AND or XOR gates over \a ins
+    uint32_t make_tree(std::vector<uint32_t> ins, bool is_xor)
+    {
+        if (ins.empty()) return is_xor ? AIG_FALSE : AIG_TRUE;
+        while (ins.size() > 1)
+        {
+            size_t num = 0;
+            for (size_t i = 0; i + 1 < ins.size(); i += 2)
+                ins[num++] = is_xor ? make_xor(ins[i], ins[i + 1]) : make_and(ins[i], ins[i + 1]);
+            if (ins.size() % 2 == 1) ins[num++] = ins.back();
+            ins.resize(num);
+        }
+        return ins[0];
+    }
+};
+
+/// Appends \a value as an AIGER varint
+void put_varint(std::string& out, uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+} // namespace
+
+aiger_info_t cxxsat::write_aiger(const VarManager& manager, const std::string& path,
+                                 const std::vector<var_t>& outputs)
+{
+    const size_t num_vars = static_cast<size_t>(manager.num_vars());
+    std::vector<definition_t> definitions;
+    std::vector<uint32_t> definition_of(num_vars + 1, NO_DEFINITION);
+
+    // The first gate found for a variable defines it, if all of its inputs are older
+    auto define = [&](gate_kind_t kind, std::vector<var_t> ins, var_t out) {
+        if (is_const(out)) return;
+        const var_t var = abs_var_t(out);
+        if (definition_of[as_int(var)] != NO_DEFINITION) return;
+        for (const var_t x : ins)
+            if (!is_const(x) && abs_var_t(x) >= var) return;
+        definition_of[as_int(var)] = static_cast<uint32_t>(definitions.size());
+        definitions.push_back({kind, std::move(ins), is_negated(out)});
+    };
+    for (const auto& entry : manager.m_and_cache)
+        define(gate_kind_t::AND, {entry.first[0], entry.first[1]}, entry.second);
+    // Each XOR is cached under all three pairs, only the one with the newest output is kept
+    for (const auto& entry : manager.m_xor_cache)
+        define(gate_kind_t::XOR, {entry.first[0], entry.first[1]}, entry.second);
+    for (const auto& entry : manager.m_mux_cache)
+        define(gate_kind_t::MUX, {entry.first[0], entry.first[1], entry.first[2]}, entry.second);
+    for (const auto& entry : manager.m_xor3_cache)
+        define(gate_kind_t::XOR3, {entry.first[0], entry.first[1], entry.first[2]}, entry.second);
+    for (const auto& entry : manager.m_maj_cache)
+        define(gate_kind_t::MAJ, {entry.first[0], entry.first[1], entry.first[2]}, entry.second);
+    for (const auto& entry : manager.m_and_n_cache)
+        define(gate_kind_t::AND_N, entry.first, entry.second);
+    for (const auto& entry : manager.m_xor_n_cache)
+        define(gate_kind_t::XOR_N, entry.first, entry.second);
+
+    aiger_info_t info;
+    info.num_ands = 0;
+    if (outputs.empty())
+    {
+        // Gate outputs that do not feed another gate
+        std::vector<bool> used(num_vars + 1, false);
+        for (const definition_t& def : definitions)
+            for (const var_t x : def.ins)
+                if (!is_const(x)) used[as_int(abs_var_t(x))] = true;
+        for (size_t v = 1; v <= num_vars; v++)
+            if (definition_of[v] != NO_DEFINITION && !used[v]) info.outputs.push_back(as_var(static_cast<int32_t>(v)));
+    }
+    else
+    {
+        for (const var_t x : outputs)
+            Assert(is_legal(x) && manager.is_known(x), ILLEGAL_OUTPUT_AIGER);
+        info.outputs = outputs;
+    }
+
+    // Cone of influence of the outputs
+    std::vector<bool> needed(num_vars + 1, false);
+    std::vector<var_t> stack;
+    for (const var_t x : info.outputs)
+        if (!is_const(x)) stack.push_back(abs_var_t(x));
+    while (!stack.empty())
+    {
+        const var_t var = stack.back();
+        stack.pop_back();
+        if (needed[as_int(var)]) continue;
+        needed[as_int(var)] = true;
+        const uint32_t index = definition_of[as_int(var)];
+        if (index == NO_DEFINITION) continue;
+        for (const var_t x : definitions[index].ins)
+            if (!is_const(x) && !needed[as_int(abs_var_t(x))]) stack.push_back(abs_var_t(x));
+    }
+
+    // Inputs come first, gates follow in variable order which is topological
+    std::vector<uint32_t> aig_of(num_vars + 1, AIG_FALSE);
+    for (size_t v = 1; v <= num_vars; v++)
+    {
+        if (!needed[v] || definition_of[v] != NO_DEFINITION) continue;
+        info.inputs.push_back(as_var(static_cast<int32_t>(v)));
+        aig_of[v] = 2 * static_cast<uint32_t>(info.inputs.size());
+    }
+    auto literal = [&](var_t x) -> uint32_t {
+        if (x == var_t::ONE) return AIG_TRUE;
+        if (x == var_t::ZERO) return AIG_FALSE;
+        return aig_of[as_int(abs_var_t(x))] ^ static_cast<uint32_t>(is_negated(x));
+    };
+
+    AigBuilder aig(static_cast<uint32_t>(info.inputs.size()));
+    std::vector<uint32_t> ins;
+    for (size_t v = 1; v <= num_vars; v++)
+    {
+        if (!needed[v] || definition_of[v] == NO_DEFINITION) continue;
+        const definition_t& def = definitions[definition_of[v]];
+        ins.clear();
+        for (const var_t x : def.ins) ins.push_back(literal(x));
+        uint32_t res;
+        switch (def.kind)
+        {
+        case gate_kind_t::AND:  res = aig.make_and(ins[0], ins[1]); break;
+        case gate_kind_t::XOR:  res = aig.make_xor(ins[0], ins[1]); break;
+        case gate_kind_t::MUX:  res = aig.make_mux(ins[0], ins[1], ins[2]); break;
+        case gate_kind_t::XOR3: res = aig.make_xor(aig.make_xor(ins[0], ins[1]), ins[2]); break;
+        case gate_kind_t::MAJ:  res = aig.make_maj(ins[0], ins[1], ins[2]); break;
+        case gate_kind_t::AND_N: res = aig.make_tree(ins, false); break;
+        default: res = aig.make_tree(ins, true); break;
+        }
+        aig_of[v] = res ^ static_cast<uint32_t>(def.neg);
+    }
+
+    const uint32_t num_inputs = static_cast<uint32_t>(info.inputs.size());
+    const uint32_t num_ands = static_cast<uint32_t>(aig.ands().size());
+    info.num_ands = num_ands;
+    std::string text = "aig " + std::to_string(num_inputs + num_ands) + " " + std::to_string(num_inputs) +
+                       " 0 " + std::to_string(info.outputs.size()) + " " + std::to_string(num_ands) + "\n";
+    for (const var_t x : info.outputs) text += std::to_string(literal(x)) + "\n";
+    for (uint32_t i = 0; i < num_ands; i++)
+    {
+        const uint32_t lhs = 2 * (num_inputs + i + 1);
+        put_varint(text, lhs - aig.ands()[i].first);
+        put_varint(text, aig.ands()[i].first - aig.ands()[i].second);
+    }
+    for (uint32_t i = 0; i < num_inputs; i++)
+        text += "i" + std::to_string(i) + " " + std::to_string(as_int(info.inputs[i])) + "\n";
+    for (size_t i = 0; i < info.outputs.size(); i++)
+        text += "o" + std::to_string(i) + " " + std::to_string(as_int(info.outputs[i])) + "\n";
+    text += "c\nwritten by cxxsat\n";
+
+    std::ofstream out(path, std::ios::binary);
+    if (!out) throw std::runtime_error("Cannot open " + path + " for writing");
+    out.write(text.data(), static_cast<std::streamsize>(text.size()));
+    if (!out) throw std::runtime_error("Cannot write AIGER file " + path);
+    DEBUG(1) << "wrote " << num_inputs << " inputs, " << info.outputs.size() << " outputs and "
+             << num_ands << " ANDs to " << path << std::endl;
+    return info;
+}
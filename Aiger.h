@@ -0,0 +1,34 @@
+#ifndef CXXSAT_AIGER_H
+#define CXXSAT_AIGER_H
+
+#include "VarManager.h"
+#include <string>
+#include <vector>
+
+namespace cxxsat {
+
+constexpr const char* ILLEGAL_OUTPUT_AIGER = "AIGER outputs must be known legal literals";
+
+/// Correspondence between an exported AIGER file and the solver variables
+struct aiger_info_t {
+    /// Solver variable of every AIGER input, in order
+    std::vector<var_t> inputs;
+    /// Solver literal of every AIGER output, in order
+    std::vector<var_t> outputs;
+    /// Number of AND gates in the file
+    uint32_t num_ands;
+};
+
+/// Writes the gates in the caches of \a manager as a binary AIGER file to \a path. XOR, MUX,
+/// majority and n-ary gates are lowered to two-input ANDs with structural hashing. Only the
+/// cone of \a outputs is exported, if it is empty all gate outputs that do not feed another
+/// gate are used. Variables without a gate definition become inputs, and a gate is only taken
+/// as a definition if its inputs are older variables than its output, which keeps the circuit
+/// acyclic. Input and output symbols name the solver variables. Throws std::runtime_error on
+/// I/O errors
+aiger_info_t write_aiger(const VarManager& manager, const std::string& path,
+                         const std::vector<var_t>& outputs = {});
+
+} // namespace cxxsat
+
+#endif // CXXSAT_AIGER_H
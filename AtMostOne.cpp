@@ -0,0 +1,286 @@
+#include "Solver.h"
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+using cxxsat::Solver;
+using cxxsat::var_t;
+using cxxsat::amo_encoding_t;
+
+namespace {
+
+/// Number of inputs sharing a commander variable
+constexpr uint32_t COMMANDER_GROUP = 3;
+/// Number of inputs up to which the recursive encodings use pairwise clauses
+constexpr uint32_t AMO_PAIRWISE_BASE = 4;
+
+/// Returns the number of bits that tell \a num values apart
+inline uint32_t bits_for(uint32_t num)
+{
+    uint32_t bits = 0;
+    while ((uint64_t(1) << bits) < num) bits++;
+    return bits;
+}
+
+/// Returns the number of rows and columns of the product grid over \a n inputs
+inline std::pair<uint32_t, uint32_t> product_grid(uint32_t n)
+{
+    const uint32_t cols = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(n))));
+    return {(n + cols - 1) / cols, cols};
+}
+
+/// Returns the number of clauses plus auxiliary variables of encode_amo over \a n inputs
+uint64_t amo_cost(uint32_t n, amo_encoding_t encoding)
+{
+    if (n < 2) return 0;
+    const uint64_t pairwise = uint64_t(n) * (n - 1) / 2;
+    if (encoding == amo_encoding_t::LADDER) return 4 * uint64_t(n) - 7;
+    if (n <= AMO_PAIRWISE_BASE) return pairwise;
+    switch (encoding)
+    {
+        case amo_encoding_t::COMMANDER:
+        {
+            // Pairwise clauses, implications and the commander of each group, a single input commands itself
+            uint64_t cost = 0;
+            for (uint32_t i = 0; i < n; i += COMMANDER_GROUP)
+            {
+                const uint64_t size = std::min(COMMANDER_GROUP, n - i);
+                if (size > 1) cost += size * (size - 1) / 2 + size + 1;
+            }
+            return cost + amo_cost((n + COMMANDER_GROUP - 1) / COMMANDER_GROUP, encoding);
+        }
+        case amo_encoding_t::PRODUCT:
+        {
+            const auto grid = product_grid(n);
+            return 2 * uint64_t(n) + grid.first + grid.second
+                 + amo_cost(grid.first, encoding) + amo_cost(grid.second, encoding);
+        }
+        case amo_encoding_t::BIMANDER:
+        {
+            const uint64_t bits = bits_for((n + 1) / 2);
+            return n / 2 + n * bits + bits;
+        }
+        default: return pairwise;
+    }
+}
+
+} // namespace
+
+amo_encoding_t Solver::choose_amo_encoding(uint32_t n)
+{
+    amo_encoding_t best = amo_encoding_t::PAIRWISE;
+    uint64_t best_cost = amo_cost(n, best);
+    for (const amo_encoding_t encoding : {amo_encoding_t::LADDER, amo_encoding_t::COMMANDER,
+                                          amo_encoding_t::PRODUCT, amo_encoding_t::BIMANDER})
+    {
+        const uint64_t cost = amo_cost(n, encoding);
+        if (cost >= best_cost) continue;
+        best = encoding;
+        best_cost = cost;
+    }
+    return best;
+}
+
+uint32_t Solver::amo_inputs(const std::vector<var_t>& ins, std::vector<var_t>& actual)
+{
+    uint32_t num_ones = 0;
+    actual.reserve(ins.size());
+    for (var_t in_var : ins)
+    {
+        Assert(is_legal(in_var), ILLEGAL_LITERAL);
+        Assert(is_known(in_var), UNKNOWN_LITERAL);
+        in_var = substitute(in_var);
+        if (in_var == var_t::ONE) num_ones += 1;
+        else if (in_var != var_t::ZERO) actual.push_back(in_var);
+    }
+    return num_ones;
+}
+
+void Solver::encode_amo(const std::vector<var_t>& ins, amo_encoding_t encoding, var_t act)
+{
+    if (ins.size() < 2) return;
+    const uint32_t n = static_cast<uint32_t>(ins.size());
+    if (encoding == amo_encoding_t::AUTO) encoding = choose_amo_encoding(n);
+    // The recursive encodings bottom out in pairwise clauses
+    if (n <= AMO_PAIRWISE_BASE && encoding != amo_encoding_t::LADDER) encoding = amo_encoding_t::PAIRWISE;
+    switch (encoding)
+    {
+        case amo_encoding_t::PAIRWISE:  encode_amo_pairwise(ins, act); break;
+        case amo_encoding_t::LADDER:    encode_amo_ladder(ins, act); break;
+        case amo_encoding_t::COMMANDER: encode_amo_commander(ins, act); break;
+        case amo_encoding_t::PRODUCT:   encode_amo_product(ins, act); break;
+        case amo_encoding_t::BIMANDER:  encode_amo_bimander(ins, act); break;
+        default: Assert(false, ILLEGAL_AMO_ENCODING);
+    }
+}
+
+void Solver::encode_amo_pairwise(const std::vector<var_t>& ins, var_t act)
+{
+    for (size_t i = 0; i < ins.size(); i++)
+        for (size_t j = i + 1; j < ins.size(); j++)
+            add_clause(-act, -ins[i], -ins[j]);
+}
+
+void Solver::encode_amo_ladder(const std::vector<var_t>& ins, var_t act)
+{
+    // The prefix is implied by the inputs before i, the first input is its own prefix.
+    // Only the conflicts need the activation, the prefixes can always be set
+    var_t prefix = ins[0];
+    for (size_t i = 1; i < ins.size(); i++)
+    {
+        add_clause(-act, -prefix, -ins[i]);
+        if (i + 1 == ins.size()) break;
+        const var_t next = new_var();
+        add_clause(-ins[i], next);
+        add_clause(-prefix, next);
+        prefix = next;
+    }
+}
+
+// Klieber and Kwon, Efficient CNF Encoding for Selecting 1 from N Objects, CFV 2007
+void Solver::encode_amo_commander(const std::vector<var_t>& ins, var_t act)
+{
+    std::vector<var_t> commanders;
+    commanders.reserve((ins.size() + COMMANDER_GROUP - 1) / COMMANDER_GROUP);
+    std::vector<var_t> group;
+    for (size_t i = 0; i < ins.size(); i += COMMANDER_GROUP)
+    {
+        group.assign(ins.begin() + i, ins.begin() + std::min(ins.size(), i + COMMANDER_GROUP));
+        if (group.size() == 1) { commanders.push_back(group[0]); continue; }
+        encode_amo_pairwise(group, act);
+        const var_t c = new_var();
+        for (const var_t x : group) add_clause(-x, c);
+        commanders.push_back(c);
+    }
+    encode_amo(commanders, amo_encoding_t::COMMANDER, act);
+}
+
+// Chen, A New SAT Encoding of the At-Most-One Constraint, ModRef 2010
+void Solver::encode_amo_product(const std::vector<var_t>& ins, var_t act)
+{
+    // Two distinct inputs differ in their row or in their column
+    const auto grid = product_grid(static_cast<uint32_t>(ins.size()));
+    std::vector<var_t> rows, cols;
+    for (uint32_t i = 0; i < grid.first; i++) rows.push_back(new_var());
+    for (uint32_t i = 0; i < grid.second; i++) cols.push_back(new_var());
+    for (size_t i = 0; i < ins.size(); i++)
+    {
+        add_clause(-ins[i], rows[i / grid.second]);
+        add_clause(-ins[i], cols[i % grid.second]);
+    }
+    encode_amo(rows, amo_encoding_t::PRODUCT, act);
+    encode_amo(cols, amo_encoding_t::PRODUCT, act);
+}
+
+// Nguyen and Mai, A New Method to Encode the At-Most-One Constraint into SAT, SoICT 2015
+void Solver::encode_amo_bimander(const std::vector<var_t>& ins, var_t act)
+{
+    // Every pair of inputs forces its index onto the shared bits, which two pairs cannot both do
+    const uint32_t num_bits = bits_for(static_cast<uint32_t>((ins.size() + 1) / 2));
+    std::vector<var_t> bits;
+    for (uint32_t b = 0; b < num_bits; b++) bits.push_back(new_var());
+    for (size_t i = 0; i < ins.size(); i++)
+    {
+        if (i % 2 == 1) add_clause(-act, -ins[i - 1], -ins[i]);
+        for (uint32_t b = 0; b < num_bits; b++)
+            add_clause(-act, -ins[i], ((i / 2) >> b) & 1 ? bits[b] : -bits[b]);
+    }
+}
+
+var_t Solver::make_at_most_one(const std::vector<var_t>& ins, amo_encoding_t encoding)
+{
+    const call_scope_t scope(*this);
+    if (scope.traced())
+    {
+        trace_lits(trace_op_t::AT_MOST_ONE, ins.data(), ins.size());
+        m_trace->write_uint(static_cast<uint32_t>(encoding));
+    }
+    std::vector<var_t> actual;
+    const uint32_t num_ones = amo_inputs(ins, actual);
+    if (num_ones != 0 || actual.size() <= 2)
+    {
+        stats_of(gate_kind_t::CARD).folds += 1;
+        if (num_ones > 1) return var_t::ZERO;
+        if (num_ones == 1) return -make_or(actual);
+        return (actual.size() == 2) ? -make_and(actual[0], actual[1]) : var_t::ONE;
+    }
+
+    const int nvars_start = num_vars();
+    const int nclauses_start = num_clauses();
+    const var_t r = new_var();
+    encode_amo(actual, encoding, r);
+
+    // Without r, some input is set together with an earlier one, which the prefix of the earlier inputs tells
+    std::vector<var_t> pairs = {r};
+    var_t prefix = actual[0];
+    for (size_t i = 1; i < actual.size(); i++)
+    {
+        const var_t t = new_var();
+        add_clause(-t, actual[i]);
+        add_clause(-t, prefix);
+        pairs.push_back(t);
+        if (i + 1 == actual.size()) break;
+        const var_t next = new_var();
+        add_clause(-next, prefix, actual[i]);
+        prefix = next;
+    }
+    add_clause(pairs);
+
+    count_emitted(gate_kind_t::CARD, nvars_start, nclauses_start);
+    DEBUG(1) << "at-most-one constraint added " << num_vars() - nvars_start << " new variables and "
+             << num_clauses() - nclauses_start << " new clauses" << std::endl;
+    return r;
+}
+
+var_t Solver::make_exactly_one(const std::vector<var_t>& ins, amo_encoding_t encoding)
+{
+    const call_scope_t scope(*this);
+    if (scope.traced())
+    {
+        trace_lits(trace_op_t::EXACTLY_ONE, ins.data(), ins.size());
+        m_trace->write_uint(static_cast<uint32_t>(encoding));
+    }
+    const var_t amo = make_at_most_one(ins, encoding);
+    return make_and(amo, make_or(ins));
+}
+
+void Solver::add_at_most_one(const std::vector<var_t>& ins, amo_encoding_t encoding, var_t act)
+{
+    const call_scope_t scope(*this);
+    if (scope.traced())
+    {
+        trace_lits(trace_op_t::ADD_AT_MOST_ONE, ins.data(), ins.size());
+        m_trace->write_uint(static_cast<uint32_t>(encoding));
+        m_trace->write_lit(act, num_vars());
+    }
+    Assert(is_legal(act), ILLEGAL_LITERAL);
+    Assert(is_known(act), UNKNOWN_LITERAL);
+    std::vector<var_t> actual;
+    const uint32_t num_ones = amo_inputs(ins, actual);
+    act = substitute(act);
+    if (act == var_t::ZERO) return;
+
+    const int nvars_start = num_vars();
+    const int nclauses_start = num_clauses();
+    if (num_ones > 1) add_clause(-act);
+    else if (num_ones == 1) for (const var_t x : actual) add_clause(-act, -x);
+    else encode_amo(actual, encoding, act);
+    count_emitted(gate_kind_t::CARD, nvars_start, nclauses_start);
+}
+
+void Solver::add_exactly_one(const std::vector<var_t>& ins, amo_encoding_t encoding, var_t act)
+{
+    const call_scope_t scope(*this);
+    if (scope.traced())
+    {
+        trace_lits(trace_op_t::ADD_EXACTLY_ONE, ins.data(), ins.size());
+        m_trace->write_uint(static_cast<uint32_t>(encoding));
+        m_trace->write_lit(act, num_vars());
+    }
+    add_at_most_one(ins, encoding, act);
+    const int nclauses_start = num_clauses();
+    std::vector<var_t> clause = ins;
+    clause.push_back(-act);
+    add_clause(clause);
+    count_emitted(gate_kind_t::CARD, num_vars(), nclauses_start);
+}
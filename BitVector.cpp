@@ -0,0 +1,347 @@
+#include "BitVector.h"
+#include <algorithm>
+
+using cxxsat::BitVector;
+using cxxsat::Solver;
+using cxxsat::var_t;
+
+namespace {
+
+enum class shift_t { SHL, LSHR, ASHR };
+
+/// Ripple-carry adder of full-adder cells that also returns the carry out
+BitVector add_with_carry(Solver& solver, const BitVector& a, const BitVector& b, var_t carry, var_t& carry_out)
+{
+    Assert(a.width() == b.width(), cxxsat::WIDTH_MISMATCH);
+    std::vector<var_t> sum;
+    sum.reserve(a.width());
+    for (uint32_t i = 0; i < a.width(); i++)
+    {
+        sum.push_back(solver.make_xor3(a[i], b[i], carry));
+        carry = solver.make_maj(a[i], b[i], carry);
+    }
+    carry_out = carry;
+    return BitVector(std::move(sum));
+}
+
+/// Logarithmic barrel shifter with one layer of MUX gates per bit of \a amount
+BitVector barrel_shift(Solver& solver, const BitVector& a, const BitVector& amount, shift_t kind)
+{
+    const uint32_t width = a.width();
+    BitVector cur = a;
+    for (uint32_t k = 0; k < amount.width(); k++)
+    {
+        const uint32_t shift = (k < 31) ? std::min<uint32_t>(uint32_t(1) << k, width) : width;
+        BitVector shifted;
+        switch (kind)
+        {
+            case shift_t::SHL:  shifted = cur.shl(shift); break;
+            case shift_t::LSHR: shifted = cur.lshr(shift); break;
+            case shift_t::ASHR: shifted = cur.ashr(shift); break;
+        }
+        cur = cxxsat::bv_ite(solver, amount[k], shifted, cur);
+    }
+    return cur;
+}
+
+} // namespace
+
+///////////////////////////////// STRUCTURE /////////////////////////////////
+
+BitVector BitVector::constant(uint64_t value, uint32_t width)
+{
+    std::vector<var_t> bits;
+    bits.reserve(width);
+    for (uint32_t i = 0; i < width; i++)
+        bits.push_back(from_bool(i < 64 && ((value >> i) & 1)));
+    return BitVector(std::move(bits));
+}
+
+BitVector BitVector::fresh(Solver& solver, uint32_t width)
+{
+    std::vector<var_t> bits;
+    bits.reserve(width);
+    for (uint32_t i = 0; i < width; i++)
+        bits.push_back(solver.new_var());
+    return BitVector(std::move(bits));
+}
+
+BitVector BitVector::extract(uint32_t hi, uint32_t lo) const
+{
+    Assert(lo <= hi && hi < width(), ILLEGAL_EXTRACT);
+    return BitVector({m_bits.begin() + lo, m_bits.begin() + hi + 1});
+}
+
+BitVector BitVector::concat(const BitVector& low) const
+{
+    std::vector<var_t> bits(low.m_bits);
+    bits.insert(bits.end(), m_bits.begin(), m_bits.end());
+    return BitVector(std::move(bits));
+}
+
+BitVector BitVector::zext(uint32_t width) const
+{
+    Assert(width >= this->width(), ILLEGAL_EXTRACT);
+    std::vector<var_t> bits(m_bits);
+    bits.resize(width, var_t::ZERO);
+    return BitVector(std::move(bits));
+}
+
+BitVector BitVector::sext(uint32_t width) const
+{
+    Assert(width >= this->width() && !m_bits.empty(), ILLEGAL_EXTRACT);
+    std::vector<var_t> bits(m_bits);
+    bits.resize(width, msb());
+    return BitVector(std::move(bits));
+}
+
+BitVector BitVector::shl(uint32_t amount) const
+{
+    std::vector<var_t> bits(width(), var_t::ZERO);
+    for (uint32_t i = amount; i < width(); i++)
+        bits[i] = m_bits[i - amount];
+    return BitVector(std::move(bits));
+}
+
+BitVector BitVector::lshr(uint32_t amount) const
+{
+    std::vector<var_t> bits(width(), var_t::ZERO);
+    for (uint32_t i = amount; i < width(); i++)
+        bits[i - amount] = m_bits[i];
+    return BitVector(std::move(bits));
+}
+
+BitVector BitVector::ashr(uint32_t amount) const
+{
+    if (m_bits.empty()) return *this;
+    std::vector<var_t> bits(width(), msb());
+    for (uint32_t i = amount; i < width(); i++)
+        bits[i - amount] = m_bits[i];
+    return BitVector(std::move(bits));
+}
+
+BitVector BitVector::operator~() const
+{
+    std::vector<var_t> bits;
+    bits.reserve(width());
+    for (var_t bit : m_bits) bits.push_back(-bit);
+    return BitVector(std::move(bits));
+}
+
+///////////////////////////////// BITWISE /////////////////////////////////
+
+BitVector cxxsat::bv_and(Solver& solver, const BitVector& a, const BitVector& b)
+{
+    Assert(a.width() == b.width(), WIDTH_MISMATCH);
+    std::vector<var_t> bits;
+    bits.reserve(a.width());
+    for (uint32_t i = 0; i < a.width(); i++) bits.push_back(solver.make_and(a[i], b[i]));
+    return BitVector(std::move(bits));
+}
+
+BitVector cxxsat::bv_or(Solver& solver, const BitVector& a, const BitVector& b)
+{
+    Assert(a.width() == b.width(), WIDTH_MISMATCH);
+    std::vector<var_t> bits;
+    bits.reserve(a.width());
+    for (uint32_t i = 0; i < a.width(); i++) bits.push_back(solver.make_or(a[i], b[i]));
+    return BitVector(std::move(bits));
+}
+
+BitVector cxxsat::bv_xor(Solver& solver, const BitVector& a, const BitVector& b)
+{
+    Assert(a.width() == b.width(), WIDTH_MISMATCH);
+    std::vector<var_t> bits;
+    bits.reserve(a.width());
+    for (uint32_t i = 0; i < a.width(); i++) bits.push_back(solver.make_xor(a[i], b[i]));
+    return BitVector(std::move(bits));
+}
+
+BitVector cxxsat::bv_ite(Solver& solver, var_t s, const BitVector& t, const BitVector& e)
+{
+    Assert(t.width() == e.width(), WIDTH_MISMATCH);
+    std::vector<var_t> bits;
+    bits.reserve(t.width());
+    for (uint32_t i = 0; i < t.width(); i++) bits.push_back(solver.make_mux(s, t[i], e[i]));
+    return BitVector(std::move(bits));
+}
+
+///////////////////////////////// ARITHMETIC /////////////////////////////////
+
+BitVector cxxsat::bv_add(Solver& solver, const BitVector& a, const BitVector& b, var_t carry_in)
+{
+    var_t carry_out;
+    return add_with_carry(solver, a, b, carry_in, carry_out);
+}
+
+BitVector cxxsat::bv_sub(Solver& solver, const BitVector& a, const BitVector& b)
+{
+    return bv_add(solver, a, ~b, var_t::ONE);
+}
+
+BitVector cxxsat::bv_neg(Solver& solver, const BitVector& a)
+{
+    return bv_add(solver, BitVector::constant(0, a.width()), ~a, var_t::ONE);
+}
+
+// Dadda reduction, see https://en.wikipedia.org/wiki/Dadda_multiplier
+BitVector cxxsat::bv_mul(Solver& solver, const BitVector& a, const BitVector& b)
+{
+    Assert(a.width() == b.width(), WIDTH_MISMATCH);
+    const uint32_t width = a.width();
+
+    // Column c collects all partial products of weight 2^c below the width
+    std::vector<std::vector<var_t>> columns(width);
+    size_t max_height = 0;
+    for (uint32_t i = 0; i < width; i++)
+        for (uint32_t j = 0; i + j < width; j++)
+        {
+            const var_t pp = solver.make_and(a[i], b[j]);
+            if (pp == var_t::ZERO) continue;
+            columns[i + j].push_back(pp);
+            max_height = std::max(max_height, columns[i + j].size());
+        }
+
+    // Dadda's height limits 2, 3, 4, 6, 9, ... below the current maximum height
+    std::vector<size_t> limits = {2};
+    while (limits.back() * 3 / 2 < max_height) limits.push_back(limits.back() * 3 / 2);
+
+    for (auto limit = limits.rbegin(); limit != limits.rend(); ++limit)
+    {
+        std::vector<var_t> carries, next_carries;
+        for (uint32_t c = 0; c < width; c++)
+        {
+            // Columns are processed as queues, so sums are only reduced again if needed
+            std::vector<var_t>& column = columns[c];
+            column.insert(column.end(), carries.begin(), carries.end());
+            next_carries.clear();
+            size_t head = 0;
+            while (column.size() - head > *limit)
+            {
+                const var_t x = column[head], y = column[head + 1];
+                if (column.size() - head == *limit + 1)
+                {
+                    next_carries.push_back(solver.make_and(x, y));
+                    column.push_back(solver.make_xor(x, y));
+                    head += 2;
+                    continue;
+                }
+                const var_t z = column[head + 2];
+                next_carries.push_back(solver.make_maj(x, y, z));
+                column.push_back(solver.make_xor3(x, y, z));
+                head += 3;
+            }
+            column.erase(column.begin(), column.begin() + static_cast<std::ptrdiff_t>(head));
+            carries.swap(next_carries);
+        }
+    }
+
+    // Each column now holds at most two bits, which a final ripple-carry adder sums up
+    std::vector<var_t> row0(width, var_t::ZERO), row1(width, var_t::ZERO);
+    for (uint32_t c = 0; c < width; c++)
+    {
+        if (columns[c].size() > 0) row0[c] = columns[c][0];
+        if (columns[c].size() > 1) row1[c] = columns[c][1];
+    }
+    return bv_add(solver, BitVector(std::move(row0)), BitVector(std::move(row1)));
+}
+
+std::pair<BitVector, BitVector> cxxsat::bv_udivrem(Solver& solver, const BitVector& a, const BitVector& b)
+{
+    Assert(a.width() == b.width(), WIDTH_MISMATCH);
+    const uint32_t width = a.width();
+
+    // The partial remainder stays below b, so one extra bit suffices for the shifted value
+    const BitVector divisor = b.zext(width + 1);
+    BitVector rem = BitVector::constant(0, width + 1);
+    std::vector<var_t> quotient(width, var_t::ZERO);
+    for (uint32_t i = width; i-- > 0;)
+    {
+        std::vector<var_t> shifted;
+        shifted.reserve(width + 1);
+        shifted.push_back(a[i]);
+        shifted.insert(shifted.end(), rem.bits().begin(), rem.bits().end() - 1);
+        rem = BitVector(std::move(shifted));
+
+        // There is no borrow in rem - divisor iff rem >= divisor
+        var_t no_borrow;
+        const BitVector diff = add_with_carry(solver, rem, ~divisor, var_t::ONE, no_borrow);
+        quotient[i] = no_borrow;
+        rem = bv_ite(solver, no_borrow, diff, rem);
+    }
+    return {BitVector(std::move(quotient)), rem.extract(width - 1, 0)};
+}
+
+BitVector cxxsat::bv_udiv(Solver& solver, const BitVector& a, const BitVector& b)
+{
+    return bv_udivrem(solver, a, b).first;
+}
+
+BitVector cxxsat::bv_urem(Solver& solver, const BitVector& a, const BitVector& b)
+{
+    return bv_udivrem(solver, a, b).second;
+}
+
+///////////////////////////////// SHIFTS /////////////////////////////////
+
+BitVector cxxsat::bv_shl(Solver& solver, const BitVector& a, const BitVector& amount)
+{
+    return barrel_shift(solver, a, amount, shift_t::SHL);
+}
+
+BitVector cxxsat::bv_lshr(Solver& solver, const BitVector& a, const BitVector& amount)
+{
+    return barrel_shift(solver, a, amount, shift_t::LSHR);
+}
+
+BitVector cxxsat::bv_ashr(Solver& solver, const BitVector& a, const BitVector& amount)
+{
+    return barrel_shift(solver, a, amount, shift_t::ASHR);
+}
+
+///////////////////////////////// COMPARISONS /////////////////////////////////
+
+var_t cxxsat::bv_eq(Solver& solver, const BitVector& a, const BitVector& b)
+{
+    Assert(a.width() == b.width(), WIDTH_MISMATCH);
+    std::vector<var_t> equal;
+    equal.reserve(a.width());
+    for (uint32_t i = 0; i < a.width(); i++) equal.push_back(-solver.make_xor(a[i], b[i]));
+    return solver.make_and(equal);
+}
+
+var_t cxxsat::bv_ult(Solver& solver, const BitVector& a, const BitVector& b)
+{
+    Assert(a.width() == b.width(), WIDTH_MISMATCH);
+    // The most significant differing bit decides, so fold from the least significant one
+    var_t lt = var_t::ZERO;
+    for (uint32_t i = 0; i < a.width(); i++)
+        lt = solver.make_mux(solver.make_xor(a[i], b[i]), b[i], lt);
+    return lt;
+}
+
+var_t cxxsat::bv_ule(Solver& solver, const BitVector& a, const BitVector& b)
+{
+    return -bv_ult(solver, b, a);
+}
+
+var_t cxxsat::bv_slt(Solver& solver, const BitVector& a, const BitVector& b)
+{
+    // Flipping the sign bits maps signed to unsigned order
+    std::vector<var_t> sa(a.bits()), sb(b.bits());
+    if (!sa.empty()) { sa.back() = -sa.back(); sb.back() = -sb.back(); }
+    return bv_ult(solver, BitVector(std::move(sa)), BitVector(std::move(sb)));
+}
+
+var_t cxxsat::bv_sle(Solver& solver, const BitVector& a, const BitVector& b)
+{
+    return -bv_slt(solver, b, a);
+}
+
+uint64_t cxxsat::bv_value(Solver& solver, const BitVector& a)
+{
+    uint64_t value = 0;
+    for (uint32_t i = 0; i < a.width() && i < 64; i++)
+        value |= uint64_t(solver.value(a[i])) << i;
+    return value;
+}
@@ -0,0 +1,95 @@
+#ifndef CXXSAT_BITVECTOR_H
+#define CXXSAT_BITVECTOR_H
+
+#include "Solver.h"
+#include <vector>
+#include <utility>
+
+namespace cxxsat {
+
+constexpr const char* WIDTH_MISMATCH = "Bit-vectors must have the same width";
+constexpr const char* ILLEGAL_EXTRACT = "Extracted bits must lie inside the bit-vector";
+
+/// Fixed-width bit-vector of solver literals, with the least significant bit first.
+/// Structural operations need no solver, all others build their cells through the gate caches.
+class BitVector {
+private:
+    std::vector<var_t> m_bits;
+public:
+    BitVector() = default;
+    explicit BitVector(std::vector<var_t> bits) : m_bits(std::move(bits)) { }
+
+    /// Creates the constant \a value truncated to \a width bits
+    static BitVector constant(uint64_t value, uint32_t width);
+    /// Creates a bit-vector of \a width fresh variables
+    static BitVector fresh(Solver& solver, uint32_t width);
+
+    /// Returns the number of bits
+    inline uint32_t width() const noexcept { return static_cast<uint32_t>(m_bits.size()); }
+    /// Returns the bit at position \a i
+    inline var_t operator[](uint32_t i) const { return m_bits[i]; }
+    /// Returns the most significant bit
+    inline var_t msb() const { return m_bits.back(); }
+    /// Returns all bits
+    inline const std::vector<var_t>& bits() const noexcept { return m_bits; }
+
+    /// Returns the bits hi down to lo, both inclusive
+    BitVector extract(uint32_t hi, uint32_t lo) const;
+    /// Returns this bit-vector as the high part above \a low
+    BitVector concat(const BitVector& low) const;
+    /// Extends the bit-vector with zeros to \a width bits
+    BitVector zext(uint32_t width) const;
+    /// Extends the bit-vector with copies of the sign bit to \a width bits
+    BitVector sext(uint32_t width) const;
+    /// Shifts left by a constant amount, filling with zeros
+    BitVector shl(uint32_t amount) const;
+    /// Shifts right by a constant amount, filling with zeros
+    BitVector lshr(uint32_t amount) const;
+    /// Shifts right by a constant amount, filling with the sign bit
+    BitVector ashr(uint32_t amount) const;
+    /// Returns the bitwise negation
+    BitVector operator~() const;
+
+    bool operator==(const BitVector& other) const { return m_bits == other.m_bits; }
+    bool operator!=(const BitVector& other) const { return m_bits != other.m_bits; }
+};
+
+/// Bitwise operations
+BitVector bv_and(Solver& solver, const BitVector& a, const BitVector& b);
+BitVector bv_or(Solver& solver, const BitVector& a, const BitVector& b);
+BitVector bv_xor(Solver& solver, const BitVector& a, const BitVector& b);
+/// Returns \a t if \a s is set and \a e otherwise
+BitVector bv_ite(Solver& solver, var_t s, const BitVector& t, const BitVector& e);
+
+/// Ripple-carry addition with full-adder cells, the carry out is dropped
+BitVector bv_add(Solver& solver, const BitVector& a, const BitVector& b, var_t carry_in = var_t::ZERO);
+/// Subtraction as a + ~b + 1
+BitVector bv_sub(Solver& solver, const BitVector& a, const BitVector& b);
+/// Two's complement negation
+BitVector bv_neg(Solver& solver, const BitVector& a);
+/// Multiplication modulo 2^width, reducing the partial products with a Dadda tree
+BitVector bv_mul(Solver& solver, const BitVector& a, const BitVector& b);
+/// Unsigned restoring division, returning quotient and remainder.
+/// Division by zero yields all ones and the dividend, as in SMT-LIB
+std::pair<BitVector, BitVector> bv_udivrem(Solver& solver, const BitVector& a, const BitVector& b);
+BitVector bv_udiv(Solver& solver, const BitVector& a, const BitVector& b);
+BitVector bv_urem(Solver& solver, const BitVector& a, const BitVector& b);
+
+/// Shifts by a variable amount, amounts of at least the width shift out all bits
+BitVector bv_shl(Solver& solver, const BitVector& a, const BitVector& amount);
+BitVector bv_lshr(Solver& solver, const BitVector& a, const BitVector& amount);
+BitVector bv_ashr(Solver& solver, const BitVector& a, const BitVector& amount);
+
+/// Comparisons returning a single literal
+var_t bv_eq(Solver& solver, const BitVector& a, const BitVector& b);
+var_t bv_ult(Solver& solver, const BitVector& a, const BitVector& b);
+var_t bv_ule(Solver& solver, const BitVector& a, const BitVector& b);
+var_t bv_slt(Solver& solver, const BitVector& a, const BitVector& b);
+var_t bv_sle(Solver& solver, const BitVector& a, const BitVector& b);
+
+/// Returns the value assigned to \a a, requires the solver to be in STATE_SAT
+uint64_t bv_value(Solver& solver, const BitVector& a);
+
+} // namespace cxxsat
+
+#endif // CXXSAT_BITVECTOR_H
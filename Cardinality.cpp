@@ -0,0 +1,359 @@
+#include "Solver.h"
+#include "Totalizer.h"
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+using cxxsat::Solver;
+using cxxsat::var_t;
+using cxxsat::card_encoding_t;
+
+namespace {
+
+/// Returns the unary digit "value >= i" of the counter \a digits
+inline var_t unary_digit(const std::vector<var_t>& digits, uint32_t i)
+{
+    if (i == 0) return var_t::ONE;
+    if (i > digits.size()) return var_t::ZERO;
+    return digits[i - 1];
+}
+
+/// Allocates \a num consecutive fresh variables used as unary digits
+std::vector<var_t> new_digits(Solver& solver, uint32_t num)
+{
+    std::vector<var_t> digits;
+    digits.reserve(num);
+    if (num == 0) return digits;
+    const int32_t first = as_int(solver.new_vars(static_cast<int>(num)));
+    for (uint32_t i = 0; i < num; i++)
+        digits.push_back(cxxsat::as_var(first + static_cast<int32_t>(i)));
+    return digits;
+}
+
+/// Modulus used by the modulo totalizer for the bound \a k
+inline uint32_t modulo_for(uint32_t k)
+{
+    return std::max<uint32_t>(2, static_cast<uint32_t>(std::ceil(std::sqrt(k + 1.0))));
+}
+
+/// Number of clauses emitted by a truncated merge of unary counters of sizes \a a and \a b
+inline uint64_t merge_cost(uint64_t a, uint64_t b, uint64_t r)
+{
+    return 2 * std::min((a + 1) * (b + 1), r * (std::min(a, b) + 1));
+}
+
+/// Node of a modulo totalizer holding the unary remainder and quotient of its inputs
+struct modulo_node_t {
+    uint32_t size;
+    std::vector<var_t> lower;
+    std::vector<var_t> upper;
+};
+
+} // namespace
+
+var_t Solver::make_at_most(const std::vector<var_t>& ins, uint32_t k, card_encoding_t encoding)
+{
+    const call_scope_t scope(*this);
+    if (scope.traced()) trace_constraint(trace_op_t::AT_MOST, ins, {}, k, static_cast<uint32_t>(encoding));
+    // Constant inputs are folded into the bound before encoding
+    std::vector<var_t> actual;
+    actual.reserve(ins.size());
+    for (var_t in_var : ins)
+    {
+        Assert(is_legal(in_var), ILLEGAL_LITERAL);
+        Assert(is_known(in_var), UNKNOWN_LITERAL);
+        in_var = substitute(in_var);
+        if (in_var == var_t::ZERO) continue;
+        if (in_var == var_t::ONE)
+        {
+            if (k == 0) { stats_of(gate_kind_t::CARD).folds += 1; return var_t::ZERO; }
+            k -= 1;
+            continue;
+        }
+        actual.push_back(in_var);
+    }
+
+    if (k == 0 || k >= actual.size())
+    {
+        stats_of(gate_kind_t::CARD).folds += 1;
+        return (k == 0) ? -make_or(actual) : var_t::ONE;
+    }
+
+    // One-hot constraints have cheaper dedicated encodings
+    if (encoding == card_encoding_t::AUTO && k == 1) return make_at_most_one(actual);
+
+    const uint32_t n = static_cast<uint32_t>(actual.size());
+    if (encoding == card_encoding_t::AUTO)
+        encoding = choose_card_encoding(n, k);
+
+    const uint32_t nvars_start = num_vars();
+    const uint32_t nclauses_start = num_clauses();
+
+    var_t res = var_t::ILLEGAL;
+    switch (encoding)
+    {
+        case card_encoding_t::SEQUENTIAL:       res = make_at_most_sequential(actual, k); break;
+        case card_encoding_t::TOTALIZER:        res = make_at_most_totalizer(actual, k); break;
+        case card_encoding_t::MODULO_TOTALIZER: res = make_at_most_modulo_totalizer(actual, k); break;
+        case card_encoding_t::SORTING_NETWORK:  res = make_at_most_sorting_network(actual, k); break;
+        default: throw std::logic_error("Unknown cardinality encoding");
+    }
+
+    // The incremental totalizer counts its clauses itself
+    if (encoding != card_encoding_t::TOTALIZER)
+        count_emitted(gate_kind_t::CARD, nvars_start, nclauses_start);
+    DEBUG(1) << "at-most constraint added " << num_vars() - nvars_start << " new variables and "
+             << num_clauses() - nclauses_start << " new clauses" << std::endl;
+    return res;
+}
+
+var_t Solver::make_at_least(const std::vector<var_t>& ins, uint32_t k, card_encoding_t encoding)
+{
+    const call_scope_t scope(*this);
+    if (scope.traced()) trace_constraint(trace_op_t::AT_LEAST, ins, {}, k, static_cast<uint32_t>(encoding));
+    if (k == 0) return var_t::ONE;
+    return -make_at_most(ins, k - 1, encoding);
+}
+
+card_encoding_t Solver::choose_card_encoding(uint32_t n, uint32_t k)
+{
+    const uint64_t m = k + 1;
+    const uint64_t p = modulo_for(k);
+
+    // Simulate the pairwise merging of the totalizers on counter sizes only
+    uint64_t cost_tot = 0, cost_mod = 0;
+    std::vector<uint64_t> sizes(n, 1), next;
+    while (sizes.size() != 1)
+    {
+        next.clear();
+        for (size_t i = 0; i + 1 < sizes.size(); i += 2)
+        {
+            const uint64_t a = sizes[i], b = sizes[i + 1];
+            cost_tot += merge_cost(std::min(a, m), std::min(b, m), std::min(a + b, m));
+            const uint64_t la = std::min(a, p - 1), lb = std::min(b, p - 1);
+            const uint64_t ua = std::min(a / p, m / p + 1), ub = std::min(b / p, m / p + 1);
+            cost_mod += 2 * merge_cost(la, lb, std::min(a + b, p - 1)) + 2 * p;
+            cost_mod += 2 * merge_cost(ua, ub, std::min((a + b) / p, m / p + 1));
+            next.push_back(a + b);
+        }
+        if (sizes.size() % 2 == 1) next.push_back(sizes.back());
+        sizes.swap(next);
+    }
+
+    uint64_t wires = 1, depth = 0;
+    while (wires < n) { wires <<= 1; depth += 1; }
+    const uint64_t cost_sort = 6 * (wires * depth * (depth + 1) / 4);
+    const uint64_t cost_seq = 6 * static_cast<uint64_t>(n) * k;
+
+    card_encoding_t best = card_encoding_t::TOTALIZER;
+    uint64_t best_cost = cost_tot;
+    if (cost_mod < best_cost)  { best = card_encoding_t::MODULO_TOTALIZER; best_cost = cost_mod; }
+    if (cost_sort < best_cost) { best = card_encoding_t::SORTING_NETWORK; best_cost = cost_sort; }
+    if (cost_seq < best_cost)  { best = card_encoding_t::SEQUENTIAL; }
+    return best;
+}
+
+// implementation of https://link.springer.com/content/pdf/10.1007%2F11564751_73.pdf
+var_t Solver::make_at_most_sequential(const std::vector<var_t>& ins, uint32_t k)
+{
+    std::vector<var_t> s;
+    s.resize(k, var_t::ZERO);
+
+    std::vector<var_t> ns;
+    ns.reserve(k);
+
+    std::vector<var_t> v;
+    v.reserve(ins.size());
+
+    // Iterate over all but the last input
+    for (uint32_t i = 0; i < ins.size() - 1; i++)
+    {
+        ns.clear(); ns.resize(k, var_t::ILLEGAL);
+        ns[0] = make_or(ins[i], s[0]);
+        for (uint32_t j = 1; j < k; j++)
+        {
+            ns[j] = make_or(s[j], make_and(s[j-1], ins[i]));
+        }
+        v.push_back(make_and(ins[i], s[k-1]));
+        s = ns;
+    }
+
+    // compute v for last input
+    v.push_back(make_and(ins[ins.size() - 1], s[k-1]));
+
+    return -make_or(v);
+}
+
+void Solver::encode_unary_sum(const std::vector<var_t>& a, const std::vector<var_t>& b,
+                              const std::vector<var_t>& r, uint32_t from)
+{
+    const uint32_t na = static_cast<uint32_t>(a.size());
+    const uint32_t nb = static_cast<uint32_t>(b.size());
+    for (uint32_t s = from + 1; s <= r.size(); s++)
+    {
+        const var_t rs = r[s - 1];
+        // a >= i and b >= s - i implies r >= s
+        for (uint32_t i = (s > nb ? s - nb : 0); i <= std::min(s, na); i++)
+            add_clause(-unary_digit(a, i), -unary_digit(b, s - i), rs);
+        // a < i + 1 and b < s - i implies r < s
+        for (uint32_t i = (s - 1 > nb ? s - 1 - nb : 0); i <= std::min(s - 1, na); i++)
+            add_clause(unary_digit(a, i + 1), unary_digit(b, s - i), -rs);
+    }
+}
+
+// implementation of https://doi.org/10.1007/978-3-540-45193-8_8 with outputs truncated at k + 1
+var_t Solver::make_at_most_totalizer(const std::vector<var_t>& ins, uint32_t k)
+{
+    Totalizer totalizer(*this, ins);
+    return totalizer.at_most(k);
+}
+
+// implementation of https://doi.org/10.1109/ICTAI.2013.72 with full equivalence on all digits
+var_t Solver::make_at_most_modulo_totalizer(const std::vector<var_t>& ins, uint32_t k)
+{
+    const uint32_t p = modulo_for(k);
+    const uint32_t tq = (k + 1) / p, tr = (k + 1) % p;
+    const uint32_t mu = tq + 1;
+
+    std::vector<modulo_node_t> level, next;
+    level.reserve(ins.size());
+    for (var_t in_var : ins) level.push_back({1, {in_var}, {}});
+
+    while (level.size() != 1)
+    {
+        next.clear();
+        for (size_t i = 0; i + 1 < level.size(); i += 2)
+        {
+            const std::vector<var_t>& la = level[i].lower;
+            const std::vector<var_t>& lb = level[i + 1].lower;
+            const std::vector<var_t>& ua = level[i].upper;
+            const std::vector<var_t>& ub = level[i + 1].upper;
+            const uint32_t nla = la.size(), nlb = lb.size();
+            const uint32_t nua = ua.size(), nub = ub.size();
+
+            modulo_node_t node;
+            node.size = level[i].size + level[i + 1].size;
+            node.lower = new_digits(*this, std::min(node.size, p - 1));
+            node.upper = new_digits(*this, std::min(node.size / p, mu));
+
+            // The carry is set iff the remainders add up to at least p
+            var_t carry = var_t::ZERO;
+            if (nla + nlb >= p)
+            {
+                carry = new_var();
+                for (uint32_t x = p - nlb; x <= nla; x++)
+                    add_clause(-unary_digit(la, x), -unary_digit(lb, p - x), carry);
+                for (uint32_t x = (p - 1 > nlb ? p - 1 - nlb : 0); x <= std::min(p - 1, nla); x++)
+                    add_clause(unary_digit(la, x + 1), unary_digit(lb, p - x), -carry);
+            }
+
+            // lower >= s iff (la + lb >= s and no carry) or la + lb >= p + s
+            for (uint32_t s = 1; s <= node.lower.size(); s++)
+            {
+                const var_t ls = node.lower[s - 1];
+                for (uint32_t x = (s > nlb ? s - nlb : 0); x <= std::min(s, nla); x++)
+                    add_clause(-unary_digit(la, x), -unary_digit(lb, s - x), carry, ls);
+                for (uint32_t x = (p + s > nlb ? p + s - nlb : 0); x <= std::min(p + s, nla); x++)
+                    add_clause(-unary_digit(la, x), -unary_digit(lb, p + s - x), ls);
+                for (uint32_t x = (s - 1 > nlb ? s - 1 - nlb : 0); x <= std::min(s - 1, nla); x++)
+                    add_clause(unary_digit(la, x + 1), unary_digit(lb, s - x), -ls);
+                // When la + lb cannot reach p + s, a carry alone rules out ls
+                const uint32_t lo = std::min(p + s - 1 > nlb ? p + s - 1 - nlb : 0, nla);
+                for (uint32_t x = lo; x <= std::min(p + s - 1, nla); x++)
+                    add_clause(unary_digit(la, x + 1), unary_digit(lb, p + s - x), -carry, -ls);
+            }
+
+            // upper >= s iff ua + ub + carry >= s
+            for (uint32_t s = 1; s <= node.upper.size(); s++)
+            {
+                const var_t us = node.upper[s - 1];
+                for (uint32_t x = (s > nub ? s - nub : 0); x <= std::min(s, nua); x++)
+                    add_clause(-unary_digit(ua, x), -unary_digit(ub, s - x), us);
+                for (uint32_t x = (s - 1 > nub ? s - 1 - nub : 0); x <= std::min(s - 1, nua); x++)
+                    add_clause(-unary_digit(ua, x), -unary_digit(ub, s - 1 - x), -carry, us);
+                for (uint32_t x = (s - 1 > nub ? s - 1 - nub : 0); x <= std::min(s - 1, nua); x++)
+                    add_clause(unary_digit(ua, x + 1), unary_digit(ub, s - x), carry, -us);
+                if (s < 2) continue;
+                for (uint32_t x = (s - 2 > nub ? s - 2 - nub : 0); x <= std::min(s - 2, nua); x++)
+                    add_clause(unary_digit(ua, x + 1), unary_digit(ub, s - 1 - x), -us);
+            }
+
+            next.push_back(std::move(node));
+        }
+        if (level.size() % 2 == 1) next.push_back(std::move(level.back()));
+        level.swap(next);
+    }
+
+    // SUM(ins) >= k + 1 iff quotient > tq or (quotient == tq and remainder >= tr)
+    const modulo_node_t& root = level[0];
+    const var_t ge = make_or(unary_digit(root.upper, tq + 1),
+                             make_and(unary_digit(root.upper, tq), unary_digit(root.lower, tr)));
+    return -ge;
+}
+
+// implementation of Batcher's odd-even merge sort, see https://doi.org/10.1145/1468075.1468121
+var_t Solver::make_at_most_sorting_network(const std::vector<var_t>& ins, uint32_t k)
+{
+    uint32_t n = 1;
+    while (n < ins.size()) n <<= 1;
+
+    // Comparators sort in descending order, so wire k is set iff SUM(ins) >= k + 1
+    std::vector<std::pair<uint32_t, uint32_t>> comps;
+    for (uint32_t p = 1; p < n; p <<= 1)
+        for (uint32_t q = p; q >= 1; q >>= 1)
+            for (uint32_t j = q % p; j + q < n; j += 2 * q)
+                for (uint32_t i = 0; i < std::min(q, n - j - q); i++)
+                    if ((i + j) / (2 * p) == (i + j + q) / (2 * p))
+                        comps.emplace_back(i + j, i + j + q);
+
+    // Only encode the comparator outputs in the cone of influence of wire k
+    std::vector<uint8_t> used(comps.size(), 0);
+    std::vector<bool> needed(n, false);
+    needed[k] = true;
+    for (size_t c = comps.size(); c-- > 0;)
+    {
+        const uint32_t hi = comps[c].first, lo = comps[c].second;
+        used[c] = (needed[hi] ? 1 : 0) | (needed[lo] ? 2 : 0);
+        if (used[c] != 0) needed[hi] = needed[lo] = true;
+    }
+
+    std::vector<var_t> wires(ins);
+    wires.resize(n, var_t::ZERO);
+    for (size_t c = 0; c < comps.size(); c++)
+    {
+        if (used[c] == 0) continue;
+        const var_t a = wires[comps[c].first], b = wires[comps[c].second];
+        if (used[c] & 1)
+        {
+            var_t hi;
+            if (a == var_t::ONE || b == var_t::ONE) hi = var_t::ONE;
+            else if (a == var_t::ZERO || a == b) hi = b;
+            else if (b == var_t::ZERO) hi = a;
+            else
+            {
+                hi = new_var();
+                add_clause(-a, hi);
+                add_clause(-b, hi);
+                add_clause(a, b, -hi);
+            }
+            wires[comps[c].first] = hi;
+        }
+        if (used[c] & 2)
+        {
+            var_t lo;
+            if (a == var_t::ZERO || b == var_t::ZERO) lo = var_t::ZERO;
+            else if (a == var_t::ONE || a == b) lo = b;
+            else if (b == var_t::ONE) lo = a;
+            else
+            {
+                lo = new_var();
+                add_clause(a, -lo);
+                add_clause(b, -lo);
+                add_clause(-a, -b, lo);
+            }
+            wires[comps[c].second] = lo;
+        }
+    }
+
+    return -wires[k];
+}
@@ -0,0 +1,260 @@
+#include "Solver.h"
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <functional>
+
+using cxxsat::Solver;
+using cxxsat::var_t;
+using cxxsat::gate_kind_t;
+
+void Solver::set_deferred(bool enable)
+{
+    if (!enable) emit_deferred();
+    m_deferred = enable;
+    m_lazy = m_lazy && enable;
+    m_polarity = m_polarity && enable;
+}
+
+void Solver::set_lazy(bool enable)
+{
+    m_deferred = m_deferred || enable;
+    m_lazy = enable;
+    m_polarity = m_polarity && enable;
+}
+
+void Solver::set_polarity(bool enable)
+{
+    m_deferred = m_deferred || enable;
+    m_lazy = m_lazy || enable;
+    m_polarity = enable;
+}
+
+void Solver::define_gate(gate_kind_t kind, const std::array<var_t, 3>& ins, var_t r)
+{
+    m_state = STATE_INPUT;
+    if (!m_deferred)
+    {
+        encode_gate(kind, ins, r);
+        if (kind == gate_kind_t::XOR) define_xor(ins[0], ins[1], r);
+        return;
+    }
+    const size_t var = static_cast<size_t>(as_int(r));
+    if (m_nodes.size() <= var)
+        m_nodes.resize(static_cast<size_t>(num_vars()) + 1,
+                       node_t{{var_t::ZERO, var_t::ZERO, var_t::ZERO}, gate_kind_t::AND, node_state_t::NONE, 0, 0, 0});
+    // The inputs only become pending once the clauses of this gate reference them
+    for (const var_t x : ins)
+    {
+        const size_t in = static_cast<size_t>(as_int(abs_var_t(x)));
+        if (in < m_nodes.size() && m_nodes[in].refs != UINT32_MAX) m_nodes[in].refs += 1;
+    }
+    m_nodes[var] = node_t{ins, kind, m_lazy ? node_state_t::DORMANT : node_state_t::PENDING, 0,
+                          m_lazy ? uint8_t(0) : POLARITY_BOTH, 0};
+    if (!m_lazy) m_pending.push_back(static_cast<int32_t>(var));
+}
+
+const Solver::node_t* Solver::node_of(var_t x, gate_kind_t kind) const
+{
+    const size_t var = static_cast<size_t>(as_int(abs_var_t(x)));
+    if (var >= m_nodes.size()) return nullptr;
+    const node_t& node = m_nodes[var];
+    if (node.state == node_state_t::NONE || node.kind != kind) return nullptr;
+    return &node;
+}
+
+var_t Solver::rewrite_and(var_t a, var_t b)
+{
+    // The two-level rules of Brummayer and Biere, which never create more than one new gate
+    var_t res = var_t::ILLEGAL;
+    for (uint32_t turn = 0; turn < 2 && res == var_t::ILLEGAL; turn++, std::swap(a, b))
+    {
+        const node_t* na = node_of(a, gate_kind_t::AND);
+        if (na == nullptr) continue;
+        const var_t a0 = na->ins[0], a1 = na->ins[1];
+        const node_t* nb = node_of(b, gate_kind_t::AND);
+        const var_t b0 = nb != nullptr ? nb->ins[0] : var_t::ILLEGAL;
+        const var_t b1 = nb != nullptr ? nb->ins[1] : var_t::ILLEGAL;
+        if (!is_negated(a))
+        {
+            const bool opposite = nb != nullptr && (b0 == -a0 || b0 == -a1 || b1 == -a0 || b1 == -a1);
+            // Contradiction and idempotence with an input of a
+            if (b == -a0 || b == -a1) res = var_t::ZERO;
+            else if (b == a0 || b == a1) res = a;
+            // Contradiction of two ANDs, and a implying b by contradicting one of its inputs
+            else if (opposite) res = is_negated(b) ? a : var_t::ZERO;
+            // Substitution of the input shared with a negated AND
+            else if (nb != nullptr && is_negated(b) && (b0 == a0 || b0 == a1)) res = make_and(a, -b1);
+            else if (nb != nullptr && is_negated(b) && (b1 == a0 || b1 == a1)) res = make_and(a, -b0);
+        }
+        else
+        {
+            // Subsumption and substitution with an input of a negated AND
+            if (b == -a0 || b == -a1) res = b;
+            else if (b == a0) res = make_and(b, -a1);
+            else if (b == a1) res = make_and(b, -a0);
+            // Resolution of -AND(x, y) and -AND(x, -y) into -x
+            else if (nb != nullptr && is_negated(b))
+            {
+                if ((a0 == b0 && a1 == -b1) || (a0 == b1 && a1 == -b0)) res = -a0;
+                else if ((a1 == b0 && a0 == -b1) || (a1 == b1 && a0 == -b0)) res = -a1;
+            }
+        }
+    }
+    if (res == var_t::ILLEGAL) return res;
+    stats_of(gate_kind_t::AND).folds += 1;
+    hits += 1;
+    return res;
+}
+
+var_t Solver::rewrite_xor(var_t a, var_t b)
+{
+    // XOR(a0, a1) ^ a0 is already found by the cache, which stores every XOR under all pairs.
+    // Two XORs sharing an input variable cancel it out instead
+    const node_t* na = node_of(a, gate_kind_t::XOR);
+    const node_t* nb = node_of(b, gate_kind_t::XOR);
+    if (na == nullptr || nb == nullptr) return var_t::ILLEGAL;
+    const std::array<var_t, 2> ai = {na->ins[0], na->ins[1]}, bi = {nb->ins[0], nb->ins[1]};
+    for (size_t i = 0; i < 2; i++)
+    {
+        for (size_t j = 0; j < 2; j++)
+        {
+            if (abs_var_t(ai[i]) != abs_var_t(bi[j])) continue;
+            stats_of(gate_kind_t::XOR).folds += 1;
+            hits += 1;
+            const bool neg = (is_negated(a) != is_negated(b)) != (ai[i] != bi[j]);
+            const var_t rest = make_xor(ai[1 - i], bi[1 - j]);
+            return neg ? -rest : rest;
+        }
+    }
+    return var_t::ILLEGAL;
+}
+
+void Solver::emit_node(int32_t var)
+{
+    node_t node = m_nodes[var];
+    const uint8_t polarities = node.needed & ~node.emitted;
+    node.emitted |= polarities;
+    node.state = node_state_t::EMITTED;
+    m_nodes[var] = node;
+    const var_t r = as_var(var);
+    const int nclauses_start = m_num_clauses;
+    if (node.kind != gate_kind_t::AND)
+    {
+        encode_gate(node.kind, node.ins, r, polarities);
+        // The output in its own clauses is no reference to the node
+        m_nodes[var] = node;
+        // Units on r only imply the equivalence of the inputs through both halves of the XOR
+        if (node.kind == gate_kind_t::XOR && polarities != 0 && node.emitted == POLARITY_BOTH)
+            define_xor(node.ins[0], node.ins[1], r);
+        count_emitted(node.kind, num_vars(), nclauses_start);
+        return;
+    }
+
+    // ANDs without emitted clauses that are used only by this one become part of it. The other
+    // polarity of this AND inlines them again, unless they got referenced in the meantime
+    std::vector<var_t> leaves, stack = {node.ins[0], node.ins[1]};
+    while (!stack.empty())
+    {
+        const var_t x = stack.back();
+        stack.pop_back();
+        const size_t v = static_cast<size_t>(as_int(abs_var_t(x)));
+        const bool absorb = !is_negated(x) && v < m_nodes.size() && m_nodes[v].kind == gate_kind_t::AND &&
+                            (m_nodes[v].state == node_state_t::PENDING || m_nodes[v].state == node_state_t::DORMANT) &&
+                            m_nodes[v].emitted == 0 && m_nodes[v].refs == 1;
+        if (!absorb)
+        {
+            leaves.push_back(x);
+            continue;
+        }
+        m_nodes[v].state = node_state_t::DORMANT;
+        m_nodes[v].needed = 0;
+        stack.push_back(m_nodes[v].ins[1]);
+        stack.push_back(m_nodes[v].ins[0]);
+    }
+    std::sort(leaves.begin(), leaves.end(), clause_less);
+    leaves.erase(std::unique(leaves.begin(), leaves.end()), leaves.end());
+    const bool complementary = std::adjacent_find(leaves.begin(), leaves.end(),
+                                                  [](var_t x, var_t y) { return x == -y; }) != leaves.end();
+    if (complementary)
+    {
+        // The AND is constant, so the unit covers both polarities
+        node.needed = node.emitted = POLARITY_BOTH;
+        add_clause(-r);
+    }
+    else
+    {
+        std::vector<var_t> big_clause;
+        big_clause.reserve(leaves.size() + 1);
+        for (const var_t x : leaves)
+        {
+            if (polarities & POLARITY_POS) add_clause(+x, -r);
+            big_clause.push_back(-x);
+        }
+        big_clause.push_back(r);
+        if (polarities & POLARITY_NEG) add_clause(big_clause);
+    }
+    m_nodes[var] = node;
+    count_emitted(gate_kind_t::AND, num_vars(), nclauses_start);
+}
+
+void Solver::emit_deferred()
+{
+    const call_scope_t scope(*this);
+    std::vector<int32_t> batch;
+    // Emitted clauses reference dormant nodes, which form the next batch
+    while (!m_pending.empty())
+    {
+        batch.swap(m_pending);
+        m_pending.clear();
+        // Outputs are newer than their inputs, so users come first and can inline their inputs
+        std::sort(batch.begin(), batch.end(), std::greater<int32_t>());
+        for (const int32_t var : batch)
+            if (m_nodes[var].state == node_state_t::PENDING) emit_node(var);
+    }
+}
+
+bool Solver::node_value(int32_t root)
+{
+    if (m_node_values.empty()) m_node_values.assign(m_nodes.size(), 0);
+    std::vector<int32_t> stack(1, root);
+    while (!stack.empty())
+    {
+        const int32_t var = stack.back();
+        const node_t& node = m_nodes[var];
+        std::array<bool, 3> in = {false, false, false};
+        bool ready = true;
+        for (size_t i = 0; i < in.size(); i++)
+        {
+            const var_t x = substitute(node.ins[i]);
+            if (is_const(x))
+            {
+                in[i] = (x == var_t::ONE);
+                continue;
+            }
+            const size_t v = static_cast<size_t>(as_int(abs_var_t(x)));
+            const bool emitted = v >= m_nodes.size() || m_nodes[v].state == node_state_t::NONE ||
+                                 m_nodes[v].emitted == POLARITY_BOTH;
+            if (emitted) in[i] = ipasir_val(m_solver, as_int(x)) > 0;
+            else if (m_node_values[v] != 0) in[i] = (m_node_values[v] > 0) != is_negated(x);
+            else
+            {
+                stack.push_back(static_cast<int32_t>(v));
+                ready = false;
+            }
+        }
+        if (!ready) continue;
+        stack.pop_back();
+        bool res;
+        switch (node.kind)
+        {
+        case gate_kind_t::AND:  res = in[0] && in[1]; break;
+        case gate_kind_t::XOR:  res = in[0] != in[1]; break;
+        case gate_kind_t::MUX:  res = in[0] ? in[1] : in[2]; break;
+        case gate_kind_t::XOR3: res = (in[0] != in[1]) != in[2]; break;
+        default:                res = (in[0] + in[1] + in[2]) >= 2; break;
+        }
+        m_node_values[var] = res ? 1 : -1;
+    }
+    return m_node_values[root] > 0;
+}
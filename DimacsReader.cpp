@@ -0,0 +1,250 @@
+#include "DimacsReader.h"
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <functional>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CXXSAT_HAS_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using cxxsat::Solver;
+using cxxsat::var_t;
+using cxxsat::dimacs_info_t;
+
+namespace {
+
+/// Smallest chunk worth its own thread
+constexpr size_t MIN_CHUNK_SIZE = 1 << 20;
+
+/// Read-only view of a whole file, memory-mapped where available
+class MappedFile {
+private:
+    const char* m_data;
+    size_t m_size;
+    bool m_mapped;
+    std::vector<char> m_copy;
+public:
+    explicit MappedFile(const std::string& path) : m_data(nullptr), m_size(0), m_mapped(false)
+    {
+#ifdef CXXSAT_HAS_MMAP
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("Cannot open " + path);
+        struct stat st;
+        if (::fstat(fd, &st) != 0) { ::close(fd); throw std::runtime_error("Cannot stat " + path); }
+        m_size = static_cast<size_t>(st.st_size);
+        if (m_size != 0)
+        {
+            void* data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) { ::close(fd); throw std::runtime_error("Cannot map " + path); }
+            ::madvise(data, m_size, MADV_SEQUENTIAL);
+            m_data = static_cast<const char*>(data);
+            m_mapped = true;
+        }
+        ::close(fd);
+#else
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in) throw std::runtime_error("Cannot open " + path);
+        m_copy.resize(static_cast<size_t>(in.tellg()));
+        in.seekg(0);
+        in.read(m_copy.data(), m_copy.size());
+        m_data = m_copy.data();
+        m_size = m_copy.size();
+#endif
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile()
+    {
+#ifdef CXXSAT_HAS_MMAP
+        if (m_mapped) ::munmap(const_cast<char*>(m_data), m_size);
+#endif
+    }
+
+    const char* begin() const { return m_data; }
+    const char* end() const { return m_data + m_size; }
+    size_t size() const { return m_size; }
+};
+
+/// Literals parsed from one chunk of the body
+struct chunk_t {
+    std::vector<int32_t> lits;
+    /// Set if the chunk contains the optional '%' end marker
+    bool end_marker = false;
+    /// Error message and byte offset of the first malformed token
+    std::string error;
+    size_t error_pos = 0;
+};
+
+inline bool is_space(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f'; }
+inline uint32_t digit(char c) { return static_cast<uint32_t>(static_cast<unsigned char>(c)) - '0'; }
+
+/// Parses an unsigned decimal number at \a p, returning false if there is none or it exceeds \a limit
+inline bool parse_number(const char*& p, const char* end, uint64_t limit, uint64_t& res)
+{
+    const char* start = p;
+    uint64_t value = 0;
+    uint32_t d;
+    // Numbers of at most 19 digits cannot overflow before the limit check
+    while (p < end && (d = digit(*p)) < 10 && p - start < 19)
+    {
+        value = value * 10 + d;
+        ++p;
+    }
+    res = value;
+    return p != start && (p == end || digit(*p) >= 10) && value <= limit;
+}
+
+/// Parses the body part [begin, end), which starts at the beginning of a line
+void parse_chunk(const char* base, const char* begin, const char* end, int32_t num_vars, int32_t offset,
+                 chunk_t& chunk)
+{
+    chunk.lits.reserve((end - begin) / 4);
+    const char* p = begin;
+    bool line_start = true;
+    while (p < end)
+    {
+        const char c = *p;
+        if (c == '\n') { line_start = true; ++p; continue; }
+        if (is_space(c)) { ++p; continue; }
+        if (line_start && c == 'c')
+        {
+            p = std::find(p, end, '\n');
+            continue;
+        }
+        if (line_start && c == '%') { chunk.end_marker = true; return; }
+        line_start = false;
+
+        const bool neg = (c == '-');
+        const char* token = p;
+        if (neg) ++p;
+        const char* digits = p;
+        uint64_t var;
+        const bool parsed = parse_number(p, end, static_cast<uint64_t>(num_vars), var);
+        const bool separated = (p == end || is_space(*p) || *p == '\n');
+        if (!parsed || !separated)
+        {
+            // Digits running into other characters are a malformed token, not a large variable
+            const bool junk = (p == digits) || (!separated && digit(*p) >= 10);
+            chunk.error = junk ? "Unexpected character" : "Variable exceeds the header";
+            chunk.error_pos = token - base;
+            return;
+        }
+        // Shift file variables onto the allocated solver variables
+        const int32_t lit = (var == 0) ? 0 : static_cast<int32_t>(var) + offset;
+        chunk.lits.push_back(neg ? -lit : lit);
+    }
+}
+
+/// Parses the header and returns the position after it
+const char* parse_header(const char* p, const char* end, dimacs_info_t& info)
+{
+    while (p < end)
+    {
+        if (*p == 'c' || *p == '\n' || *p == '\r') { p = std::find(p, end, '\n'); if (p < end) ++p; continue; }
+        break;
+    }
+    static const char PREFIX[] = "p cnf";
+    if (end - p < 5 || !std::equal(PREFIX, PREFIX + 5, p))
+        throw std::runtime_error("Missing DIMACS header \"p cnf\"");
+    p += 5;
+    uint64_t num_vars, num_clauses;
+    while (p < end && is_space(*p)) ++p;
+    if (!parse_number(p, end, INT32_MAX - 1, num_vars))
+        throw std::runtime_error("Malformed number of variables in DIMACS header");
+    while (p < end && is_space(*p)) ++p;
+    if (!parse_number(p, end, UINT64_MAX, num_clauses))
+        throw std::runtime_error("Malformed number of clauses in DIMACS header");
+    while (p < end && is_space(*p)) ++p;
+    if (p < end && *p != '\n') throw std::runtime_error("Unexpected text after DIMACS header");
+    info.num_vars = static_cast<int32_t>(num_vars);
+    info.num_clauses = num_clauses;
+    return (p < end) ? p + 1 : p;
+}
+
+} // namespace
+
+dimacs_info_t cxxsat::load_dimacs(Solver& solver, const std::string& path, uint32_t num_threads,
+                                  bool detect_gates)
+{
+    const MappedFile file(path);
+    dimacs_info_t info;
+    const char* body = parse_header(file.begin(), file.end(), info);
+    info.num_read = 0;
+    // File variables become the block of solver variables allocated after validation
+    const int32_t offset = solver.num_vars();
+
+    // Split the body into chunks that start at line boundaries
+    if (num_threads == 0) num_threads = std::max(1u, std::thread::hardware_concurrency());
+    const size_t body_size = file.end() - body;
+    const size_t num_chunks = std::max<size_t>(1, std::min<size_t>(num_threads, body_size / MIN_CHUNK_SIZE));
+    std::vector<const char*> bounds = {body};
+    for (size_t i = 1; i < num_chunks; i++)
+    {
+        const char* p = std::find(std::max(bounds.back(), body + i * (body_size / num_chunks)), file.end(), '\n');
+        bounds.push_back((p < file.end()) ? p + 1 : p);
+    }
+    bounds.push_back(file.end());
+
+    std::vector<chunk_t> chunks(num_chunks);
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < num_chunks; i++)
+        threads.emplace_back(parse_chunk, file.begin(), bounds[i], bounds[i + 1], info.num_vars, offset,
+                             std::ref(chunks[i]));
+    parse_chunk(file.begin(), bounds[0], bounds[1], info.num_vars, offset, chunks[0]);
+    for (std::thread& thread : threads) thread.join();
+
+    // Malformed input is rejected before any variable or clause reaches the solver
+    bool terminated = true;
+    for (const chunk_t& chunk : chunks)
+    {
+        if (!chunk.error.empty())
+            throw std::runtime_error(chunk.error + " in " + path + " at byte " + std::to_string(chunk.error_pos));
+        if (!chunk.lits.empty()) terminated = (chunk.lits.back() == 0);
+        if (chunk.end_marker) break;
+    }
+    if (!terminated) throw std::runtime_error("Last clause of " + path + " is not terminated");
+    info.first_var = (info.num_vars != 0) ? solver.new_vars(info.num_vars) : as_var(offset + 1);
+
+    // Gates are detected among the recorded clauses after loading
+    const bool was_recording = solver.is_recording();
+    if (detect_gates && !was_recording) solver.set_recording(true);
+
+    // Feed complete clauses in file order, clauses may span chunk boundaries
+    std::vector<int32_t> pending;
+    for (const chunk_t& chunk : chunks)
+    {
+        const std::vector<int32_t>& lits = chunk.lits;
+        const auto first_end = std::find(lits.begin(), lits.end(), 0);
+        if (first_end == lits.end())
+        {
+            pending.insert(pending.end(), lits.begin(), lits.end());
+        }
+        else
+        {
+            const size_t last_end = lits.rend() - std::find(lits.rbegin(), lits.rend(), 0);
+            pending.insert(pending.end(), lits.begin(), first_end + 1);
+            solver.add_clauses(pending.data(), pending.size());
+            const size_t rest = first_end + 1 - lits.begin();
+            solver.add_clauses(lits.data() + rest, last_end - rest);
+            pending.assign(lits.begin() + last_end, lits.end());
+            info.num_read += std::count(lits.begin(), lits.end(), 0);
+        }
+        if (chunk.end_marker) break;
+    }
+    if (detect_gates)
+    {
+        solver.detect_gates();
+        if (!was_recording) solver.set_recording(false);
+    }
+
+    DEBUG(1) << "loaded " << info.num_read << " clauses over " << info.num_vars << " variables from "
+             << path << " in " << num_chunks << " chunks" << std::endl;
+    return info;
+}
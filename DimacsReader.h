@@ -0,0 +1,31 @@
+#ifndef CXXSAT_DIMACSREADER_H
+#define CXXSAT_DIMACSREADER_H
+
+#include "Solver.h"
+#include <string>
+
+namespace cxxsat {
+
+/// Summary of a loaded DIMACS file
+struct dimacs_info_t {
+    /// Number of variables and clauses declared in the header
+    int32_t num_vars;
+    uint64_t num_clauses;
+    /// Number of clauses actually found in the body
+    uint64_t num_read;
+    /// Solver variable of variable 1 of the file, the others follow consecutively
+    var_t first_var;
+};
+
+/// Loads the DIMACS CNF file \a path into \a solver. The file is memory-mapped and split
+/// into chunks at line boundaries, which are parsed by up to \a num_threads threads, where
+/// 0 uses all hardware threads. Variables of the file are allocated as one block of fresh
+/// solver variables. If \a detect_gates is set, the gates defined by the clauses are
+/// registered in the gate caches of \a solver. Throws std::runtime_error on I/O errors
+/// and malformed input
+dimacs_info_t load_dimacs(Solver& solver, const std::string& path, uint32_t num_threads = 0,
+                          bool detect_gates = false);
+
+} // namespace cxxsat
+
+#endif // CXXSAT_DIMACSREADER_H
@@ -0,0 +1,199 @@
+#include "DimacsWriter.h"
+#include <stdexcept>
+#include <cstring>
+
+#ifdef CXXSAT_HAS_ZLIB
+#include <zlib.h>
+#endif
+
+using cxxsat::DimacsWriter;
+using cxxsat::var_t;
+
+#ifdef CXXSAT_HAS_ZLIB
+namespace {
+
+/// Writes \a value in little-endian byte order, used by the gzip trailer
+void put_le(unsigned char* out, uint32_t value, size_t num)
+{
+    for (size_t i = 0; i < num; i++) out[i] = static_cast<unsigned char>(value >> (8 * i));
+}
+
+} // namespace
+#endif
+
+DimacsWriter::DimacsWriter(const std::string& path, compression_t compression, int level) :
+        m_file(nullptr), m_compression(compression), m_buffer(BUFFER_SIZE),
+        m_used(0), m_max_var(0), m_num_clauses(0), m_zstream(nullptr)
+{
+#ifdef CXXSAT_HAS_ZLIB
+    if (m_compression == compression_t::GZIP)
+    {
+        z_stream* zs = new z_stream();
+        // A window of 15 bits plus 16 selects the gzip wrapper
+        if (deflateInit2(zs, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            delete zs;
+            throw std::runtime_error("Cannot initialize zlib");
+        }
+        m_zstream = zs;
+        m_zbuffer.resize(BUFFER_SIZE);
+    }
+#else
+    (void) level;
+    if (m_compression == compression_t::GZIP) throw std::runtime_error(NO_ZLIB);
+#endif
+    m_file = std::fopen(path.c_str(), "wb");
+    if (m_file == nullptr)
+    {
+        release_zstream();
+        throw std::runtime_error("Cannot open " + path + " for writing");
+    }
+    try { write_header(0, 0); }
+    catch (...)
+    {
+        release_zstream();
+        std::fclose(m_file);
+        throw;
+    }
+}
+
+DimacsWriter::~DimacsWriter()
+{
+    if (m_file == nullptr) return;
+    try { close(); } catch (const std::exception&) { }
+}
+
+std::string DimacsWriter::header(int32_t num_vars, uint64_t num_clauses)
+{
+    const std::string line = "p cnf " + std::to_string(num_vars) + " " + std::to_string(num_clauses) + "\n";
+    // The padding comment precedes the header line, which every parser accepts
+    return "c" + std::string(HEADER_SIZE - 2 - line.size(), ' ') + "\n" + line;
+}
+
+void DimacsWriter::write_header(int32_t num_vars, uint64_t num_clauses)
+{
+    const std::string text = header(num_vars, num_clauses);
+    if (m_compression == compression_t::NONE)
+    {
+        if (std::fwrite(text.data(), 1, text.size(), m_file) != text.size())
+            throw std::runtime_error("Cannot write DIMACS header");
+        return;
+    }
+#ifdef CXXSAT_HAS_ZLIB
+    // gzip member holding a single stored deflate block, so its size never changes
+    unsigned char member[18 + HEADER_SIZE + 5];
+    const unsigned char gzip_header[10] = {0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 0xff};
+    std::memcpy(member, gzip_header, 10);
+    member[10] = 1; // final stored block
+    put_le(member + 11, HEADER_SIZE, 2);
+    put_le(member + 13, static_cast<uint32_t>(~HEADER_SIZE & 0xffff), 2);
+    std::memcpy(member + 15, text.data(), HEADER_SIZE);
+    const uint32_t crc = crc32(crc32(0, nullptr, 0), reinterpret_cast<const Bytef*>(text.data()), HEADER_SIZE);
+    put_le(member + 15 + HEADER_SIZE, crc, 4);
+    put_le(member + 19 + HEADER_SIZE, HEADER_SIZE, 4);
+    if (std::fwrite(member, 1, sizeof(member), m_file) != sizeof(member))
+        throw std::runtime_error("Cannot write DIMACS header");
+#endif
+}
+
+void DimacsWriter::drain(bool finish)
+{
+    if (m_compression == compression_t::NONE)
+    {
+        if (std::fwrite(m_buffer.data(), 1, m_used, m_file) != m_used)
+            throw std::runtime_error("Cannot write DIMACS clauses");
+        m_used = 0;
+        return;
+    }
+#ifdef CXXSAT_HAS_ZLIB
+    z_stream* zs = static_cast<z_stream*>(m_zstream);
+    zs->next_in = reinterpret_cast<Bytef*>(m_buffer.data());
+    zs->avail_in = static_cast<uInt>(m_used);
+    int ret;
+    do {
+        zs->next_out = m_zbuffer.data();
+        zs->avail_out = static_cast<uInt>(m_zbuffer.size());
+        ret = deflate(zs, finish ? Z_FINISH : Z_NO_FLUSH);
+        if (ret == Z_STREAM_ERROR) throw std::runtime_error("Cannot compress DIMACS clauses");
+        const size_t produced = m_zbuffer.size() - zs->avail_out;
+        if (std::fwrite(m_zbuffer.data(), 1, produced, m_file) != produced)
+            throw std::runtime_error("Cannot write DIMACS clauses");
+    } while (zs->avail_out == 0 || (finish && ret != Z_STREAM_END));
+    m_used = 0;
+#else
+    (void) finish;
+#endif
+}
+
+void DimacsWriter::release_zstream() noexcept
+{
+#ifdef CXXSAT_HAS_ZLIB
+    if (m_zstream == nullptr) return;
+    deflateEnd(static_cast<z_stream*>(m_zstream));
+    delete static_cast<z_stream*>(m_zstream);
+    m_zstream = nullptr;
+#endif
+}
+
+void DimacsWriter::write(const int32_t* lits, size_t size)
+{
+    Assert(m_file != nullptr, WRITER_CLOSED);
+    char* const begin = m_buffer.data();
+    char* const limit = begin + m_buffer.size() - MAX_LITERAL_CHARS;
+    char* out = begin + m_used;
+    int32_t max_var = m_max_var;
+    uint64_t num_clauses = m_num_clauses;
+    for (size_t i = 0; i < size; i++)
+    {
+        const int32_t lit = lits[i];
+        if (out >= limit)
+        {
+            m_used = out - begin;
+            drain(false);
+            out = begin;
+        }
+        out = format_literal(out, lit);
+        const int32_t var = (lit < 0) ? -lit : lit;
+        max_var = (var > max_var) ? var : max_var;
+        num_clauses += (lit == 0);
+    }
+    m_used = out - begin;
+    m_max_var = max_var;
+    m_num_clauses = num_clauses;
+}
+
+void DimacsWriter::write_clause(const std::vector<var_t>& clause)
+{
+    std::vector<int32_t> lits;
+    lits.reserve(clause.size() + 1);
+    for (const var_t x : clause)
+    {
+        Assert(is_legal(x) && !is_const(x), ILLEGAL_LITERAL_DIMACS);
+        lits.push_back(as_int(x));
+    }
+    lits.push_back(0);
+    write(lits.data(), lits.size());
+}
+
+void DimacsWriter::close(int32_t num_vars)
+{
+    Assert(m_file != nullptr, WRITER_CLOSED);
+    std::FILE* file = m_file;
+    try
+    {
+        drain(true);
+        release_zstream();
+        if (std::fseek(m_file, 0, SEEK_SET) != 0)
+            throw std::runtime_error("Cannot seek to the DIMACS header");
+        write_header((num_vars > m_max_var) ? num_vars : m_max_var, m_num_clauses);
+    }
+    catch (...)
+    {
+        release_zstream();
+        m_file = nullptr;
+        std::fclose(file);
+        throw;
+    }
+    m_file = nullptr;
+    if (std::fclose(file) != 0) throw std::runtime_error("Cannot close DIMACS file");
+}
@@ -0,0 +1,94 @@
+#ifndef CXXSAT_DIMACSWRITER_H
+#define CXXSAT_DIMACSWRITER_H
+
+#include "vars.h"
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace cxxsat {
+
+constexpr const char* WRITER_CLOSED = "DIMACS writer is already closed";
+constexpr const char* ILLEGAL_LITERAL_DIMACS = "DIMACS clauses must not contain constants or illegal literals";
+constexpr const char* NO_ZLIB = "cxxsat was built without zlib, gzip output is unavailable";
+
+/// Largest number of characters of a formatted literal, including sign and separator
+constexpr size_t MAX_LITERAL_CHARS = 12;
+
+/// Writes the decimal representation of \a lit followed by a space, or a newline if
+/// \a lit is 0, and returns the position after it. Needs MAX_LITERAL_CHARS of space
+inline char* format_literal(char* out, int32_t lit) noexcept
+{
+    if (lit == 0) { *out++ = '0'; *out++ = '\n'; return out; }
+    uint32_t value = static_cast<uint32_t>(lit);
+    if (lit < 0) { *out++ = '-'; value = 0u - value; }
+    char digits[10];
+    int num = 0;
+    do { digits[num++] = static_cast<char>('0' + value % 10); value /= 10; } while (value != 0);
+    while (num > 0) *out++ = digits[--num];
+    *out++ = ' ';
+    return out;
+}
+
+/// Buffered DIMACS CNF writer. The header is written as a fixed-size region at the start
+/// of the file, which is rewritten with the final counts on close. For gzip output the
+/// region is an uncompressed first gzip member and the clauses follow as a second member.
+class DimacsWriter {
+public:
+    enum class compression_t {
+        NONE, ///< Plain text
+        GZIP  ///< Multi-member gzip, requires cxxsat to be built with zlib
+    };
+private:
+    /// Size of the header region, holding a padding comment and the header line
+    static constexpr size_t HEADER_SIZE = 64;
+    /// Size of the formatting buffer
+    static constexpr size_t BUFFER_SIZE = 1 << 20;
+
+    std::FILE* m_file;
+    compression_t m_compression;
+    std::vector<char> m_buffer;
+    size_t m_used;
+    /// Largest variable seen in a clause and number of terminated clauses
+    int32_t m_max_var;
+    uint64_t m_num_clauses;
+    /// zlib stream state of the clause member, only used for GZIP
+    void* m_zstream;
+    std::vector<unsigned char> m_zbuffer;
+
+    /// Returns the header region for the given counts
+    static std::string header(int32_t num_vars, uint64_t num_clauses);
+    /// Writes the header region at the current position
+    void write_header(int32_t num_vars, uint64_t num_clauses);
+    /// Passes the formatted text to the file, compressing it if needed
+    void drain(bool finish);
+    /// Releases the zlib stream state
+    void release_zstream() noexcept;
+public:
+    /// Creates \a path and reserves the header region, throws std::runtime_error on I/O errors
+    explicit DimacsWriter(const std::string& path, compression_t compression = compression_t::NONE,
+                          int level = 1);
+    DimacsWriter(const DimacsWriter&) = delete;
+    DimacsWriter& operator=(const DimacsWriter&) = delete;
+    /// Closes the writer if that has not happened yet, ignoring errors
+    ~DimacsWriter();
+
+    /// Appends \a size literals of 0-terminated clauses
+    void write(const int32_t* lits, size_t size);
+    /// Appends a single clause, constants are not allowed
+    void write_clause(const std::vector<var_t>& clause);
+    /// Flushes all clauses and writes the header with at least \a num_vars variables
+    void close(int32_t num_vars = 0);
+
+    /// Returns the number of written clauses
+    inline uint64_t num_clauses() const noexcept { return m_num_clauses; }
+    /// Returns the largest variable in any written clause
+    inline int32_t max_var() const noexcept { return m_max_var; }
+    /// Returns true until the writer is closed
+    inline bool is_open() const noexcept { return m_file != nullptr; }
+};
+
+} // namespace cxxsat
+
+#endif // CXXSAT_DIMACSWRITER_H
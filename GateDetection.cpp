@@ -0,0 +1,173 @@
+#include "VarManager.h"
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+using cxxsat::VarManager;
+using cxxsat::var_t;
+
+namespace {
+
+/// Index of a literal in the occurrence lists
+inline size_t lit_index(var_t x) { return 2 * static_cast<size_t>(as_int(abs_var_t(x))) + is_negated(x); }
+
+/// Returns the literals sorted by value, the form in which ternary clauses are stored
+inline ternary_key_t sorted_clause(var_t a, var_t b, var_t c)
+{
+    ternary_key_t key = {a, b, c};
+    std::sort(key.begin(), key.end());
+    return key;
+}
+
+/// Sets of sign patterns over three variables, by the parity of their negations
+constexpr uint8_t EVEN_PATTERNS = 0x69;
+constexpr uint8_t ODD_PATTERNS = 0x96;
+
+} // namespace
+
+size_t VarManager::detect_gates(const int32_t* lits, size_t size)
+{
+    // Collect the binary and ternary clauses, the others only matter as long AND clauses
+    std::vector<std::vector<var_t>> partners(2 * static_cast<size_t>(m_num_vars) + 2);
+    std::vector<ternary_key_t> ternary;
+    std::vector<var_t> store;
+    std::vector<std::pair<size_t, size_t>> long_clauses;
+    std::vector<var_t> vars;
+    size_t begin = 0;
+    for (size_t end = 0; end < size; end++)
+    {
+        if (lits[end] != 0) continue;
+        const size_t start = std::exchange(begin, end + 1);
+
+        // Only clauses over distinct known variables can be gate definitions
+        vars.clear();
+        bool valid = true;
+        for (size_t j = start; j < end && valid; j++)
+        {
+            const var_t x = as_var(lits[j]);
+            valid = is_legal(x) && !is_const(x) && is_known(x);
+            vars.push_back(abs_var_t(x));
+        }
+        if (!valid || vars.size() < 2) continue;
+        std::sort(vars.begin(), vars.end());
+        if (std::adjacent_find(vars.begin(), vars.end()) != vars.end()) continue;
+
+        const size_t offset = store.size();
+        for (size_t j = start; j < end; j++) store.push_back(as_var(lits[j]));
+        const var_t* c = store.data() + offset;
+        if (vars.size() == 2)
+        {
+            partners[lit_index(c[0])].push_back(c[1]);
+            partners[lit_index(c[1])].push_back(c[0]);
+            store.resize(offset);
+            continue;
+        }
+        if (vars.size() == 3) ternary.push_back(sorted_clause(c[0], c[1], c[2]));
+        long_clauses.emplace_back(offset, store.size());
+    }
+    for (std::vector<var_t>& list : partners) std::sort(list.begin(), list.end());
+    std::sort(ternary.begin(), ternary.end());
+    ternary.erase(std::unique(ternary.begin(), ternary.end()), ternary.end());
+
+    std::unordered_set<ternary_key_t> ternary_set(ternary.begin(), ternary.end());
+    std::vector<std::vector<uint32_t>> occurrences(partners.size());
+    for (uint32_t i = 0; i < ternary.size(); i++)
+        for (const var_t x : ternary[i]) occurrences[lit_index(x)].push_back(i);
+
+    // Every variable is recognized as the output of at most one gate
+    std::vector<bool> defined(static_cast<size_t>(m_num_vars) + 1, false);
+    size_t num_gates = 0;
+
+    // XOR(a, b) = r is defined by the four clauses whose negations have the same parity
+    std::unordered_map<ternary_key_t, uint8_t> patterns;
+    for (const ternary_key_t& clause : ternary)
+    {
+        ternary_key_t key = {abs_var_t(clause[0]), abs_var_t(clause[1]), abs_var_t(clause[2])};
+        std::sort(key.begin(), key.end());
+        uint32_t pattern = 0;
+        for (const var_t x : clause)
+            if (is_negated(x)) pattern |= 1u << (std::find(key.begin(), key.end(), abs_var_t(x)) - key.begin());
+        patterns[key] |= static_cast<uint8_t>(1u << pattern);
+    }
+    for (const auto& entry : patterns)
+    {
+        const ternary_key_t& key = entry.first;
+        const bool even = (entry.second & EVEN_PATTERNS) == EVEN_PATTERNS;
+        const bool odd = (entry.second & ODD_PATTERNS) == ODD_PATTERNS;
+        if (!even && !odd) continue;
+        // Prefer the newest variable as the output
+        size_t out = 3;
+        while (out > 0 && defined[as_int(key[out - 1])]) out--;
+        if (out-- == 0) continue;
+        // Clauses with even negations exclude the assignments of even parity
+        const var_t r = even ? -key[out] : key[out];
+        register_xor(key[(out + 1) % 3], key[(out + 2) % 3], r);
+        define_xor(key[(out + 1) % 3], key[(out + 2) % 3], r);
+        defined[as_int(key[out])] = true;
+        num_gates += 1;
+    }
+
+    // AND(a_1, ..., a_n) = r is defined by (r, -a_1, ..., -a_n) and the binary clauses (-r, a_i)
+    std::vector<var_t> ins;
+    for (const auto& range : long_clauses)
+    {
+        const var_t* c = store.data() + range.first;
+        const size_t num = range.second - range.first;
+        for (size_t j = 0; j < num; j++)
+        {
+            const var_t r = c[j];
+            const std::vector<var_t>& list = partners[lit_index(-r)];
+            if (defined[as_int(abs_var_t(r))] || list.size() < num - 1) continue;
+            ins.clear();
+            for (size_t k = 0; k < num; k++)
+            {
+                if (k == j) continue;
+                if (!std::binary_search(list.begin(), list.end(), -c[k])) break;
+                ins.push_back(-c[k]);
+            }
+            if (ins.size() != num - 1) continue;
+
+            if (ins.size() == 2) register_and(ins[0], ins[1], r);
+            else
+            {
+                std::sort(ins.begin(), ins.end(), [](var_t a, var_t b) { return abs_var_t(a) < abs_var_t(b); });
+                register_and_n(ins, r);
+            }
+            defined[as_int(abs_var_t(r))] = true;
+            num_gates += 1;
+            break;
+        }
+    }
+
+    // MUX(s, t, e) = r is defined by (-s, -t, r), (-s, t, -r), (s, -e, r) and (s, e, -r)
+    constexpr size_t ORDERS[6][3] = {{0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0}};
+    for (const ternary_key_t& clause : ternary)
+    {
+        for (const auto& order : ORDERS)
+        {
+            const var_t s = -clause[order[0]], t = -clause[order[1]], r = clause[order[2]];
+            if (defined[as_int(abs_var_t(r))]) continue;
+            if (ternary_set.count(sorted_clause(-s, t, -r)) == 0) continue;
+            // The else input is the third literal of a clause containing s and r
+            for (const uint32_t index : occurrences[lit_index(s)])
+            {
+                const ternary_key_t& other = ternary[index];
+                if (std::find(other.begin(), other.end(), r) == other.end()) continue;
+                const var_t e = -*std::find_if(other.begin(), other.end(), [&](var_t x) { return x != s && x != r; });
+                // A shared variable of t and e makes this an XOR or a plain equivalence
+                if (abs_var_t(e) == abs_var_t(t)) continue;
+                if (ternary_set.count(sorted_clause(s, e, -r)) == 0) continue;
+                register_mux(s, t, e, r);
+                defined[as_int(abs_var_t(r))] = true;
+                num_gates += 1;
+                break;
+            }
+            if (defined[as_int(abs_var_t(r))]) break;
+        }
+    }
+
+    DEBUG(1) << "detected " << num_gates << " gates in " << size << " literals" << std::endl;
+    return num_gates;
+}
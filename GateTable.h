@@ -0,0 +1,232 @@
+#ifndef CXXSAT_GATETABLE_H
+#define CXXSAT_GATETABLE_H
+
+#include "vars.h"
+#include "Stats.h"
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <cstddef>
+
+namespace cxxsat {
+
+/// Flat open-addressing hash table from gate inputs to gate outputs, using Robin Hood
+/// linear probing. Entries live inline in a single array together with their probe
+/// distance, so a lookup touches one or two cache lines and allocates nothing.
+/// Entries are never erased, matching the life cycle of the gate caches.
+template<typename Key, typename Hash = std::hash<Key>>
+class GateTable {
+public:
+    using key_type = Key;
+    using mapped_type = var_t;
+    using value_type = std::pair<Key, var_t>;
+private:
+    struct slot_t {
+        value_type entry;
+        /// Distance from the home slot plus one, or zero if the slot is empty
+        uint32_t dist;
+    };
+
+    /// Smallest non-zero capacity
+    static constexpr size_t MIN_CAPACITY = 16;
+
+    std::vector<slot_t> m_slots;
+    size_t m_size;
+    /// Number of bits of the slot index, the capacity is 2^m_bits
+    uint32_t m_bits;
+
+    /// Maps a hash to its home slot with Fibonacci hashing, which also spreads weak hashes
+    inline size_t home(const Key& key) const noexcept
+    {
+        const uint64_t h = static_cast<uint64_t>(Hash{}(key)) * UINT64_C(0x9E3779B97F4A7C15);
+        return static_cast<size_t>(h >> (64 - m_bits));
+    }
+
+    /// Reallocates the table with \a capacity slots and reinserts all entries
+    void rehash(size_t capacity);
+    /// Inserts an entry known to be absent and returns its slot
+    size_t insert_unique(value_type entry);
+public:
+    template<bool CONST>
+    class basic_iterator {
+        friend class GateTable;
+        using slot_ptr = std::conditional_t<CONST, const slot_t*, slot_t*>;
+        slot_ptr m_cur;
+        slot_ptr m_end;
+        basic_iterator(slot_ptr cur, slot_ptr end) : m_cur(cur), m_end(end) { skip(); }
+        void skip() { while (m_cur != m_end && m_cur->dist == 0) ++m_cur; }
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = GateTable::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<CONST, const value_type*, value_type*>;
+        using reference = std::conditional_t<CONST, const value_type&, value_type&>;
+
+        reference operator*() const { return m_cur->entry; }
+        pointer operator->() const { return &m_cur->entry; }
+        basic_iterator& operator++() { ++m_cur; skip(); return *this; }
+        basic_iterator operator++(int) { basic_iterator res = *this; ++(*this); return res; }
+        bool operator==(const basic_iterator& other) const { return m_cur == other.m_cur; }
+        bool operator!=(const basic_iterator& other) const { return m_cur != other.m_cur; }
+    };
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+    GateTable() : m_size(0), m_bits(0) { }
+
+    iterator begin() { return {m_slots.data(), m_slots.data() + m_slots.size()}; }
+    iterator end() { return {m_slots.data() + m_slots.size(), m_slots.data() + m_slots.size()}; }
+    const_iterator begin() const { return {m_slots.data(), m_slots.data() + m_slots.size()}; }
+    const_iterator end() const { return {m_slots.data() + m_slots.size(), m_slots.data() + m_slots.size()}; }
+
+    /// Returns the number of stored entries
+    inline size_t size() const noexcept { return m_size; }
+    /// Returns true if there are no stored entries
+    inline bool empty() const noexcept { return m_size == 0; }
+    /// Returns the number of slots
+    inline size_t capacity() const noexcept { return m_slots.size(); }
+    /// Returns the fraction of occupied slots
+    inline double load_factor() const noexcept { return m_slots.empty() ? 0.0 : double(m_size) / m_slots.size(); }
+    /// Returns the number of bytes allocated for the slots
+    inline size_t memory_usage() const noexcept { return m_slots.capacity() * sizeof(slot_t); }
+
+    /// Returns occupancy and probe length statistics, scanning all slots
+    table_stats_t stats() const;
+
+    /// Returns the entry for \a key, or end() if there is none
+    iterator find(const Key& key);
+    const_iterator find(const Key& key) const;
+    /// Inserts \a value for \a key unless \a key is already present, like std::unordered_map::emplace
+    std::pair<iterator, bool> emplace(const Key& key, var_t value);
+    /// Makes room for \a count entries without exceeding the maximum load factor
+    void reserve(size_t count);
+    /// Removes all entries and releases the slots
+    void clear();
+};
+
+template<typename Key, typename Hash>
+void GateTable<Key, Hash>::rehash(size_t capacity)
+{
+    std::vector<slot_t> old;
+    old.swap(m_slots);
+    m_slots.resize(capacity);
+    for (slot_t& slot : m_slots) slot.dist = 0;
+    m_bits = 0;
+    while ((size_t(1) << m_bits) < capacity) m_bits += 1;
+    for (slot_t& slot : old)
+        if (slot.dist != 0) insert_unique(std::move(slot.entry));
+}
+
+template<typename Key, typename Hash>
+size_t GateTable<Key, Hash>::insert_unique(value_type entry)
+{
+    const size_t mask = m_slots.size() - 1;
+    size_t pos = home(entry.first);
+    uint32_t dist = 1;
+    size_t res = SIZE_MAX;
+    while (true)
+    {
+        slot_t& slot = m_slots[pos];
+        if (slot.dist == 0)
+        {
+            slot.entry = std::move(entry);
+            slot.dist = dist;
+            return (res == SIZE_MAX) ? pos : res;
+        }
+        // Robin Hood: take the slot from entries closer to their home
+        if (slot.dist < dist)
+        {
+            std::swap(slot.entry, entry);
+            std::swap(slot.dist, dist);
+            if (res == SIZE_MAX) res = pos;
+        }
+        pos = (pos + 1) & mask;
+        dist += 1;
+    }
+}
+
+template<typename Key, typename Hash>
+typename GateTable<Key, Hash>::iterator GateTable<Key, Hash>::find(const Key& key)
+{
+    if (m_size == 0) return end();
+    const size_t mask = m_slots.size() - 1;
+    size_t pos = home(key);
+    // Entries further away than their probe distance cannot be in the table
+    for (uint32_t dist = 1; m_slots[pos].dist >= dist; dist++)
+    {
+        if (m_slots[pos].entry.first == key)
+            return {m_slots.data() + pos, m_slots.data() + m_slots.size()};
+        pos = (pos + 1) & mask;
+    }
+    return end();
+}
+
+template<typename Key, typename Hash>
+typename GateTable<Key, Hash>::const_iterator GateTable<Key, Hash>::find(const Key& key) const
+{
+    if (m_size == 0) return end();
+    const size_t mask = m_slots.size() - 1;
+    size_t pos = home(key);
+    for (uint32_t dist = 1; m_slots[pos].dist >= dist; dist++)
+    {
+        if (m_slots[pos].entry.first == key)
+            return {m_slots.data() + pos, m_slots.data() + m_slots.size()};
+        pos = (pos + 1) & mask;
+    }
+    return end();
+}
+
+template<typename Key, typename Hash>
+std::pair<typename GateTable<Key, Hash>::iterator, bool> GateTable<Key, Hash>::emplace(const Key& key, var_t value)
+{
+    auto it = find(key);
+    if (it != end()) return {it, false};
+
+    // Keep the load factor at most 7/8
+    if ((m_size + 1) * 8 > m_slots.size() * 7)
+        rehash(m_slots.empty() ? MIN_CAPACITY : 2 * m_slots.size());
+    const size_t pos = insert_unique({key, value});
+    m_size += 1;
+    return {{m_slots.data() + pos, m_slots.data() + m_slots.size()}, true};
+}
+
+template<typename Key, typename Hash>
+void GateTable<Key, Hash>::reserve(size_t count)
+{
+    size_t capacity = MIN_CAPACITY;
+    while (count * 8 > capacity * 7) capacity *= 2;
+    if (capacity > m_slots.size()) rehash(capacity);
+}
+
+template<typename Key, typename Hash>
+table_stats_t GateTable<Key, Hash>::stats() const
+{
+    table_stats_t res;
+    res.size = m_size;
+    res.capacity = capacity();
+    res.memory = memory_usage();
+    res.load_factor = load_factor();
+    uint64_t total = 0;
+    for (const slot_t& slot : m_slots)
+    {
+        total += slot.dist;
+        res.max_probe = std::max(res.max_probe, slot.dist);
+    }
+    res.mean_probe = (m_size == 0) ? 0.0 : double(total) / m_size;
+    return res;
+}
+
+template<typename Key, typename Hash>
+void GateTable<Key, Hash>::clear()
+{
+    std::vector<slot_t>().swap(m_slots);
+    m_size = 0;
+    m_bits = 0;
+}
+
+} // namespace cxxsat
+
+#endif // CXXSAT_GATETABLE_H
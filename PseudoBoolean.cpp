@@ -0,0 +1,346 @@
+#include "Solver.h"
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <numeric>
+
+using cxxsat::Solver;
+using cxxsat::var_t;
+using cxxsat::pb_encoding_t;
+
+namespace {
+
+constexpr const char* PB_SIZE_MISMATCH = "Number of weights does not match number of inputs";
+constexpr const char* PB_RANGE = "Pseudo-Boolean weights and bound exceed the range of the encodings";
+
+/// Sentinel bounds of BDD intervals, small enough to allow adding weights
+constexpr int64_t PB_INFINITY = INT64_MAX / 4;
+
+/// Largest BDD size estimate for which AUTO still chooses the BDD encoding
+constexpr uint64_t PB_BDD_LIMIT = 1 << 20;
+
+/// Returns true if a + b overflows int64_t
+inline bool add_overflows(int64_t a, int64_t b)
+{
+    return (b > 0) ? (a > INT64_MAX - b) : (a < INT64_MIN - b);
+}
+
+/// Interval [lo, hi] of bounds for which a BDD node represents the same function
+struct bdd_interval_t {
+    int64_t lo, hi;
+    var_t res;
+};
+
+/// Node of a generalized totalizer, mapping each reachable partial sum to "sum >= value"
+using gte_node_t = std::vector<std::pair<int64_t, var_t>>;
+
+/// Returns the literal of the largest value of \a node below index \a i, where index 0 is the empty sum
+inline var_t gte_digit(const gte_node_t& node, size_t i)
+{
+    if (i == 0) return var_t::ONE;
+    if (i > node.size()) return var_t::ZERO;
+    return node[i - 1].second;
+}
+
+/// Returns the value of the partial sum at index \a i, where index 0 is the empty sum
+inline int64_t gte_value(const gte_node_t& node, size_t i)
+{
+    return (i == 0) ? 0 : node[i - 1].first;
+}
+
+/// Recursive BDD construction following https://doi.org/10.1613/jair.3653
+class BddBuilder {
+private:
+    Solver& m_solver;
+    const std::vector<var_t>& m_ins;
+    const std::vector<int64_t>& m_weights;
+    /// Sum of the weights starting at each position
+    std::vector<int64_t> m_suffix;
+    /// Intervals of already built nodes on each level, keyed by their lower bound
+    std::vector<std::map<int64_t, bdd_interval_t>> m_levels;
+public:
+    BddBuilder(Solver& solver, const std::vector<var_t>& ins, const std::vector<int64_t>& weights) :
+            m_solver(solver), m_ins(ins), m_weights(weights),
+            m_suffix(ins.size() + 1, 0), m_levels(ins.size())
+    {
+        for (size_t i = ins.size(); i-- > 0;)
+            m_suffix[i] = m_suffix[i + 1] + weights[i];
+    }
+
+    bdd_interval_t build(size_t level, int64_t bound)
+    {
+        if (bound < 0) return {-PB_INFINITY, -1, var_t::ZERO};
+        if (m_suffix[level] <= bound) return {m_suffix[level], PB_INFINITY, var_t::ONE};
+
+        std::map<int64_t, bdd_interval_t>& known = m_levels[level];
+        auto it = known.upper_bound(bound);
+        if (it != known.begin() && std::prev(it)->second.hi >= bound)
+            return std::prev(it)->second;
+
+        const bdd_interval_t low = build(level + 1, bound);
+        const bdd_interval_t high = build(level + 1, bound - m_weights[level]);
+
+        bdd_interval_t res;
+        res.lo = std::max(low.lo, high.lo + m_weights[level]);
+        res.hi = std::min(low.hi, high.hi + m_weights[level]);
+        res.res = m_solver.make_mux(m_ins[level], high.res, low.res);
+        known.emplace(res.lo, res);
+        return res;
+    }
+};
+
+} // namespace
+
+var_t Solver::make_pb_le(const std::vector<var_t>& ins, const std::vector<int64_t>& weights,
+                         int64_t bound, pb_encoding_t encoding)
+{
+    const call_scope_t scope(*this);
+    if (scope.traced()) trace_constraint(trace_op_t::PB_LE, ins, weights, bound, static_cast<uint32_t>(encoding));
+    Assert(ins.size() == weights.size(), PB_SIZE_MISMATCH);
+
+    // Normalize to positive weights on distinct literals, folding constants into the bound
+    std::map<var_t, int64_t> terms;
+    for (size_t i = 0; i < ins.size(); i++)
+    {
+        var_t in_var = ins[i];
+        int64_t weight = weights[i];
+        Assert(is_legal(in_var), ILLEGAL_LITERAL);
+        Assert(is_known(in_var), UNKNOWN_LITERAL);
+        Assert(weight != INT64_MIN, PB_RANGE);
+        in_var = substitute(in_var);
+        if (weight == 0 || in_var == var_t::ZERO) continue;
+        if (in_var == var_t::ONE || weight < 0)
+        {
+            Assert(!add_overflows(bound, -weight), PB_RANGE);
+            bound -= weight;
+            if (in_var == var_t::ONE) continue;
+            // w * x == w + (-w) * (-x)
+            in_var = -in_var;
+            weight = -weight;
+        }
+        int64_t& sum = terms[in_var];
+        Assert(!add_overflows(sum, weight), PB_RANGE);
+        sum += weight;
+    }
+    gate_stats_t& stats = stats_of(gate_kind_t::PB);
+    if (bound < 0) { stats.folds += 1; return var_t::ZERO; }
+
+    std::vector<std::pair<int64_t, var_t>> sorted;
+    sorted.reserve(terms.size());
+    int64_t divisor = 0;
+    for (const auto& term : terms)
+    {
+        // Any weight above the bound alone violates the constraint
+        const int64_t weight = (bound < INT64_MAX) ? std::min(term.second, bound + 1) : term.second;
+        sorted.emplace_back(weight, term.first);
+        divisor = std::gcd(divisor, weight);
+    }
+    // Dividing by the common divisor keeps large but regular weights in range
+    if (divisor > 1)
+    {
+        for (auto& term : sorted) term.first /= divisor;
+        bound /= divisor;
+    }
+    int64_t total = 0;
+    bool overflow = false;
+    for (const auto& term : sorted)
+    {
+        overflow = overflow || add_overflows(total, term.first);
+        if (!overflow) total += term.first;
+    }
+    if (!overflow && total <= bound) { stats.folds += 1; return var_t::ONE; }
+    // The encodings add up the weights, which must stay below the sentinels of the BDD
+    Assert(!overflow && total < PB_INFINITY, PB_RANGE);
+
+    std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+        return a.first > b.first || (a.first == b.first && a.second < b.second);
+    });
+    std::vector<var_t> actual;
+    std::vector<int64_t> actual_weights;
+    actual.reserve(sorted.size());
+    actual_weights.reserve(sorted.size());
+    for (const auto& term : sorted)
+    {
+        actual.push_back(term.second);
+        actual_weights.push_back(term.first);
+    }
+
+    if (encoding == pb_encoding_t::AUTO)
+    {
+        // Equal weights are a plain cardinality constraint
+        if (actual_weights.front() == actual_weights.back())
+        {
+            stats.folds += 1;
+            return make_at_most(actual, static_cast<uint32_t>(bound / actual_weights.front()));
+        }
+
+        // Level i of the BDD has at most min(2^i, bound + 1) nodes
+        uint64_t estimate = 0;
+        for (size_t i = 0; i < actual.size(); i++)
+            estimate += (i < 63) ? std::min<uint64_t>(uint64_t(1) << i, bound + 1) : bound + 1;
+        encoding = (estimate <= PB_BDD_LIMIT) ? pb_encoding_t::BDD : pb_encoding_t::ADDER;
+    }
+
+    const uint32_t nvars_start = num_vars();
+    const uint32_t nclauses_start = num_clauses();
+
+    var_t res = var_t::ILLEGAL;
+    switch (encoding)
+    {
+        case pb_encoding_t::BDD:                   res = make_pb_le_bdd(actual, actual_weights, bound); break;
+        case pb_encoding_t::GENERALIZED_TOTALIZER: res = make_pb_le_totalizer(actual, actual_weights, bound); break;
+        case pb_encoding_t::ADDER:                 res = make_pb_le_adder(actual, actual_weights, bound); break;
+        default: throw std::logic_error("Unknown pseudo-Boolean encoding");
+    }
+
+    count_emitted(gate_kind_t::PB, nvars_start, nclauses_start);
+    DEBUG(1) << "pseudo-Boolean constraint added " << num_vars() - nvars_start << " new variables and "
+             << num_clauses() - nclauses_start << " new clauses" << std::endl;
+    return res;
+}
+
+var_t Solver::make_pb_ge(const std::vector<var_t>& ins, const std::vector<int64_t>& weights,
+                         int64_t bound, pb_encoding_t encoding)
+{
+    const call_scope_t scope(*this);
+    if (scope.traced()) trace_constraint(trace_op_t::PB_GE, ins, weights, bound, static_cast<uint32_t>(encoding));
+    // SUM(w * x) >= bound iff SUM(-w * x) <= -bound
+    Assert(bound != INT64_MIN, PB_RANGE);
+    std::vector<int64_t> neg_weights;
+    neg_weights.reserve(weights.size());
+    for (int64_t weight : weights)
+    {
+        Assert(weight != INT64_MIN, PB_RANGE);
+        neg_weights.push_back(-weight);
+    }
+    return make_pb_le(ins, neg_weights, -bound, encoding);
+}
+
+var_t Solver::make_pb_eq(const std::vector<var_t>& ins, const std::vector<int64_t>& weights,
+                         int64_t bound, pb_encoding_t encoding)
+{
+    const call_scope_t scope(*this);
+    if (scope.traced()) trace_constraint(trace_op_t::PB_EQ, ins, weights, bound, static_cast<uint32_t>(encoding));
+    return make_and(make_pb_le(ins, weights, bound, encoding),
+                    make_pb_ge(ins, weights, bound, encoding));
+}
+
+var_t Solver::make_pb_le_bdd(const std::vector<var_t>& ins, const std::vector<int64_t>& weights, int64_t bound)
+{
+    BddBuilder builder(*this, ins, weights);
+    return builder.build(0, bound).res;
+}
+
+// generalized totalizer of Joshi, Martins and Manquinho (CP 2015) with full equivalence on all sums
+var_t Solver::make_pb_le_totalizer(const std::vector<var_t>& ins, const std::vector<int64_t>& weights, int64_t bound)
+{
+    const int64_t cap = bound + 1;
+
+    std::vector<gte_node_t> level, next;
+    level.reserve(ins.size());
+    for (size_t i = 0; i < ins.size(); i++) level.push_back({{weights[i], ins[i]}});
+
+    while (level.size() != 1)
+    {
+        next.clear();
+        for (size_t i = 0; i + 1 < level.size(); i += 2)
+        {
+            const gte_node_t& a = level[i];
+            const gte_node_t& b = level[i + 1];
+
+            // Collect the distinct sums, capped at bound + 1
+            std::vector<int64_t> sums;
+            for (size_t ia = 0; ia <= a.size(); ia++)
+                for (size_t ib = 0; ib <= b.size(); ib++)
+                    sums.push_back(std::min(gte_value(a, ia) + gte_value(b, ib), cap));
+            std::sort(sums.begin(), sums.end());
+            sums.erase(std::unique(sums.begin(), sums.end()), sums.end());
+
+            gte_node_t r;
+            r.reserve(sums.size() - 1);
+            for (size_t is = 1; is < sums.size(); is++)
+                r.emplace_back(sums[is], new_var());
+
+            // a >= va and b >= vb implies r >= va + vb
+            for (size_t ia = 0; ia <= a.size(); ia++)
+                for (size_t ib = 0; ib <= b.size(); ib++)
+                {
+                    const int64_t sum = std::min(gte_value(a, ia) + gte_value(b, ib), cap);
+                    if (sum == 0) continue;
+                    const auto it = std::lower_bound(r.begin(), r.end(), std::make_pair(sum, var_t::ILLEGAL));
+                    add_clause(-gte_digit(a, ia), -gte_digit(b, ib), it->second);
+                }
+
+            // a < next(va) and b < next(vb) with va + vb < s implies r < s
+            for (const auto& out : r)
+            {
+                size_t ib = b.size() + 1;
+                for (size_t ia = 0; ia <= a.size(); ia++)
+                {
+                    const int64_t va = gte_value(a, ia);
+                    if (va >= out.first) break;
+                    while (ib > 0 && va + gte_value(b, ib - 1) >= out.first) ib -= 1;
+                    if (ib == 0) break;
+                    add_clause(gte_digit(a, ia + 1), gte_digit(b, ib), -out.second);
+                }
+            }
+
+            next.push_back(std::move(r));
+        }
+        if (level.size() % 2 == 1) next.push_back(std::move(level.back()));
+        level.swap(next);
+    }
+
+    const gte_node_t& root = level[0];
+    if (root.back().first != cap) return var_t::ONE;
+    return -root.back().second;
+}
+
+// adder network of Een and Sorensson (JSAT 2006) built from cached XOR3 and MAJ full-adder cells
+var_t Solver::make_pb_le_adder(const std::vector<var_t>& ins, const std::vector<int64_t>& weights, int64_t bound)
+{
+    // Each column holds the literals that contribute 2^column to the sum, and carries
+    // never reach beyond the width of the total weight
+    const int64_t total = std::accumulate(weights.begin(), weights.end(), int64_t(0));
+    uint32_t width = 0;
+    while ((total >> width) != 0) width += 1;
+    std::vector<std::vector<var_t>> columns(width + 1);
+    for (size_t i = 0; i < ins.size(); i++)
+        for (uint32_t bit = 0; (weights[i] >> bit) != 0; bit++)
+            if ((weights[i] >> bit) & 1) columns[bit].push_back(ins[i]);
+
+    std::vector<var_t> sum;
+    for (size_t bit = 0; bit < columns.size(); bit++)
+    {
+        // Columns are processed as queues, so carries enter the next column in creation order
+        std::vector<var_t>& column = columns[bit];
+        for (size_t head = 0; column.size() - head > 1;)
+        {
+            const var_t a = column[head], b = column[head + 1];
+            if (column.size() - head == 2)
+            {
+                columns[bit + 1].push_back(make_and(a, b));
+                column.push_back(make_xor(a, b));
+                head += 2;
+                continue;
+            }
+            const var_t c = column[head + 2];
+            columns[bit + 1].push_back(make_maj(a, b, c));
+            column.push_back(make_xor3(a, b, c));
+            head += 3;
+        }
+        sum.push_back(column.empty() ? var_t::ZERO : column.back());
+    }
+
+    // Compare the sum against the bound starting with the least significant bit
+    uint32_t bound_width = 0;
+    while ((bound >> bound_width) != 0) bound_width += 1;
+    var_t le = var_t::ONE;
+    for (uint32_t bit = 0; bit < std::max<uint32_t>(sum.size(), bound_width); bit++)
+    {
+        const var_t sb = (bit < sum.size()) ? sum[bit] : var_t::ZERO;
+        if ((bound >> bit) & 1) le = make_or(-sb, le);
+        else                    le = make_and(-sb, le);
+    }
+    return le;
+}
@@ -1,33 +1,267 @@
 #include "Solver.h"
+#include "DimacsWriter.h"
 #include <vector>
 #include <cassert>
 #include <chrono>
 
+#ifdef CXXSAT_BACKEND_CADICAL
+// Part of the C interface of CaDiCaL, whose IPASIR solver objects are CCaDiCaL objects
+extern "C" {
+struct CCaDiCaL;
+int ccadical_fixed(CCaDiCaL* solver, int lit);
+}
+#endif
+
 using cxxsat::Solver;
 using cxxsat::var_t;
 
 Solver* cxxsat::solver = nullptr;
 
+namespace {
+/// Solver of the innermost SolverScope of each thread
+thread_local Solver* scoped_solver = nullptr;
+} // namespace
+
+Solver* cxxsat::current_solver() noexcept { return scoped_solver != nullptr ? scoped_solver : solver; }
+
+cxxsat::SolverScope::SolverScope(Solver& solver) noexcept : m_previous(scoped_solver) { scoped_solver = &solver; }
+
+cxxsat::SolverScope::~SolverScope() { scoped_solver = m_previous; }
+
 Solver::Solver() :
-        m_state(STATE_INPUT), m_num_clauses(0), m_solver(ipasir_init()), m_output(nullptr)
+        m_state(STATE_INPUT), m_num_clauses(0), m_solver(ipasir_init()), m_output(nullptr), m_writer(nullptr),
+        m_recording(false), m_clause_set_enabled(false), m_trace(nullptr), m_depth(0),
+        m_harvest_fixed(true), m_num_harvest_vars(0), m_solved_since_harvest(false),
+        m_deferred(false), m_lazy(false), m_polarity(false),
+        m_num_redundant_xors(0), m_xor_shape(xor_shape_t::AUTO), m_xor_width(0)
 { }
 
 Solver::~Solver()
 {
+    // A formula built only for its DIMACS output keeps its last clauses, the backend is released anyway
+    try { write_buffer(); }
+    catch (...) { }
     ipasir_release(m_solver);
 }
 
-var_t Solver::make_and(const var_t a, const var_t b)
+void Solver::flush()
+{
+    for (const int32_t lit : m_buffer) ipasir_add(m_solver, lit);
+    if (m_recording) m_recorded.insert(m_recorded.end(), m_buffer.begin(), m_buffer.end());
+    write_buffer();
+    m_buffer.clear();
+}
+
+void Solver::write_buffer()
+{
+    if (m_writer != nullptr) m_writer->write(m_buffer.data(), m_buffer.size());
+    if (m_output != nullptr)
+    {
+        // Format in chunks instead of one stream insertion per literal
+        char text[4096];
+        char* out = text;
+        for (const int32_t lit : m_buffer)
+        {
+            if (out + cxxsat::MAX_LITERAL_CHARS > text + sizeof(text))
+            {
+                m_output->write(text, out - text);
+                out = text;
+            }
+            out = cxxsat::format_literal(out, lit);
+        }
+        m_output->write(text, out - text);
+    }
+}
+
+void Solver::trace_new_vars(int number)
+{
+    m_trace->write_op(trace_op_t::NEW_VARS);
+    m_trace->write_uint(static_cast<uint64_t>(number));
+}
+
+void Solver::trace_lits(trace_op_t op, std::initializer_list<var_t> lits)
+{
+    m_trace->write_op(op);
+    for (const var_t x : lits) m_trace->write_lit(x, num_vars());
+}
+
+void Solver::trace_lits(trace_op_t op, const var_t* lits, size_t size)
+{
+    m_trace->write_op(op);
+    m_trace->write_lits(lits, size, num_vars());
+}
+
+void Solver::trace_constraint(trace_op_t op, const std::vector<var_t>& ins, const std::vector<int64_t>& weights,
+                              int64_t bound, uint32_t encoding)
+{
+    trace_lits(op, ins.data(), ins.size());
+    for (const int64_t weight : weights) m_trace->write_int(weight);
+    m_trace->write_int(bound);
+    m_trace->write_uint(encoding);
+}
+
+void Solver::set_clause_set(bool enable)
 {
+    m_clause_set_enabled = enable;
+    if (enable) return;
+    std::vector<var_t>().swap(m_clause_arena);
+    m_clause_set.clear();
+}
+
+bool Solver::insert_clause_set(const var_t* lits, size_t size)
+{
+    const uint64_t hash = key_hash(lits, size);
+    const auto range = m_clause_set.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        const var_t* other = m_clause_arena.data() + it->second.first;
+        if (it->second.second == size && std::equal(lits, lits + size, other)) return false;
+    }
+    m_clause_set.emplace(hash, std::make_pair(m_clause_arena.size(), size));
+    m_clause_arena.insert(m_clause_arena.end(), lits, lits + size);
+    return true;
+}
+
+void Solver::set_recording(bool enable)
+{
+    flush();
+    m_recording = enable;
+    if (!enable) std::vector<int32_t>().swap(m_recorded);
+}
+
+size_t Solver::detect_gates()
+{
+    flush();
+    const size_t num_gates = detect_gates(m_recorded.data(), m_recorded.size());
+    m_recorded.clear();
+    return num_gates;
+}
+
+void Solver::add_raw_clause(const int32_t* lits, size_t begin, size_t end)
+{
+    if (tracing())
+    {
+        m_trace->write_op(trace_op_t::CLAUSE);
+        m_trace->write_uint(end - begin);
+        for (size_t i = begin; i < end; i++) m_trace->write_lit(as_var(lits[i]), num_vars());
+    }
+    for (size_t i = begin; i < end; i++)
+    {
+        const var_t x = as_var(lits[i]);
+        Assert(is_legal(x), ILLEGAL_LITERAL);
+        Assert(is_known(x), UNKNOWN_LITERAL);
+        if (x != var_t::ONE) continue;
+        DEBUG(2) << "Eliminated clause" << std::endl;
+        return;
+    }
+
+    const size_t start = m_buffer.size();
+    for (size_t i = begin; i < end; i++)
+        { if (as_var(lits[i]) != var_t::ZERO) m_buffer.push_back(lits[i]); }
+    if (!m_nodes.empty())
+        for (size_t i = start; i < m_buffer.size(); i++) use_node(as_var(m_buffer[i]));
+    if (m_buffer.size() == start + 1) assert_unit(as_var(m_buffer.back()));
+    end_clause();
+}
+
+void Solver::add_equivalence(var_t a, var_t b)
+{
+    const call_scope_t scope(*this);
+    if (scope.traced()) trace_lits(trace_op_t::EQUIVALENCE, {a, b});
+    add_clause(a, -b);
+    add_clause(-a, b);
+    assert_equivalent(a, b);
+}
+
+void Solver::add_clauses(const int32_t* lits, size_t size)
+{
+    Assert(size == 0 || lits[size - 1] == 0, UNTERMINATED_CLAUSE);
+    size_t begin = 0;
+    for (size_t i = 0; i < size; i++)
+    {
+        if (lits[i] != 0) continue;
+        add_raw_clause(lits, begin, i);
+        begin = i + 1;
+    }
+}
+
+void Solver::add_clauses(const int32_t* lits, const size_t* offsets, size_t num_clauses)
+{
+    for (size_t i = 0; i < num_clauses; i++)
+    {
+        Assert(offsets[i] <= offsets[i + 1], ILLEGAL_OFFSETS);
+        add_raw_clause(lits, offsets[i], offsets[i + 1]);
+    }
+}
+
+void Solver::encode_gate(gate_kind_t kind, const std::array<var_t, 3>& ins, var_t r, uint8_t polarities)
+{
+    const var_t a = ins[0], b = ins[1], c = ins[2];
+    const bool pos = (polarities & POLARITY_POS) != 0, neg = (polarities & POLARITY_NEG) != 0;
+    switch (kind)
+    {
+    case gate_kind_t::AND:
+        if (pos) add_clause(+a, -r);
+        if (pos) add_clause(+b, -r);
+        if (neg) add_clause(-a, -b, +r);
+        break;
+    case gate_kind_t::XOR:
+        if (pos) add_clause(-a, -b, -r);
+        if (pos) add_clause(+a, +b, -r);
+        if (neg) add_clause(-a, +b, +r);
+        if (neg) add_clause(+a, -b, +r);
+        break;
+    case gate_kind_t::MUX:
+        // MUX(s, t, e) with the redundant clauses over t and e
+        if (neg) add_clause(-a, -b, +r);
+        if (pos) add_clause(-a, +b, -r);
+        if (neg) add_clause(+a, -c, +r);
+        if (pos) add_clause(+a, +c, -r);
+        if (neg) add_clause(-b, -c, +r);
+        if (pos) add_clause(+b, +c, -r);
+        break;
+    case gate_kind_t::XOR3:
+        // Forbid every assignment with the wrong parity
+        if (neg) add_clause(-a, -b, -c, +r);
+        if (neg) add_clause(-a, +b, +c, +r);
+        if (neg) add_clause(+a, -b, +c, +r);
+        if (neg) add_clause(+a, +b, -c, +r);
+        if (pos) add_clause(+a, +b, +c, -r);
+        if (pos) add_clause(+a, -b, -c, -r);
+        if (pos) add_clause(-a, +b, -c, -r);
+        if (pos) add_clause(-a, -b, +c, -r);
+        break;
+    case gate_kind_t::MAJ:
+        if (neg) add_clause(-a, -b, +r);
+        if (neg) add_clause(-a, -c, +r);
+        if (neg) add_clause(-b, -c, +r);
+        if (pos) add_clause(+a, +b, -r);
+        if (pos) add_clause(+a, +c, -r);
+        if (pos) add_clause(+b, +c, -r);
+        break;
+    default:
+        Assert(false, NO_FIXED_ENCODING);
+    }
+}
+
+var_t Solver::make_and(var_t a, var_t b)
+{
+    const call_scope_t scope(*this);
+    if (scope.traced()) trace_lits(trace_op_t::AND, {a, b});
+    a = substitute(a), b = substitute(b);
     var_t c = simplify_and(a, b);
     if (c != var_t::ILLEGAL) return c;
+    if (m_deferred)
+    {
+        c = rewrite_and(a, b);
+        if (c != var_t::ILLEGAL) return c;
+    }
 
-    // Add the clauses for constraining the variables
+    const int nvars_start = num_vars();
+    const int nclauses_start = m_num_clauses;
     c = new_var();
-    add_clause(+a, -c);
-    add_clause(+b, -c);
-    add_clause(-a, -b, +c);
-    m_state = STATE_INPUT;
+    define_gate(gate_kind_t::AND, {a, b, var_t::ZERO}, c);
+    count_emitted(gate_kind_t::AND, nvars_start, nclauses_start);
 
     register_and(a, b, c);
     return c;
@@ -35,38 +269,63 @@ var_t Solver::make_and(const var_t a, const var_t b)
 
 var_t Solver::make_and(const std::vector<var_t>& ins)
 {
-    if (ins.empty()) return var_t::ONE;
-    if (ins.size() == 1) return ins[0];
-    if (ins.size() == 2) return make_and(ins[0], ins[1]);
-    std::vector<var_t> big_clause;
-    big_clause.reserve(ins.size() + 1);
-    bool is_false = false;
-    for (var_t in_var : ins)
+    const call_scope_t scope(*this);
+    if (scope.traced()) trace_lits(trace_op_t::AND_N, ins.data(), ins.size());
+    std::vector<var_t> actual(ins);
+    for (var_t& x : actual) x = substitute(x);
+    var_t res = simplify_and_n(actual);
+    if (res != var_t::ILLEGAL) return res;
+    if (actual.size() == 2)
     {
-        Assert(is_legal(in_var), ILLEGAL_LITERAL);
-        Assert(is_known(in_var), UNKNOWN_LITERAL);
-        is_false |= (in_var == var_t::ZERO);
+        stats_of(gate_kind_t::AND_N).folds += 1;
+        return make_and(actual[0], actual[1]);
     }
-    if (is_false) return var_t::ZERO;
 
-    var_t res = new_var();
-    for (var_t in_var : ins)
+    const int nvars_start = num_vars();
+    const int nclauses_start = m_num_clauses;
+    if (m_deferred)
     {
-        add_clause(+in_var, -res);
-        big_clause.push_back(-in_var);
+        // Balanced tree of binary nodes, emitted as one n-ary AND unless inner nodes get shared
+        std::vector<var_t> level(actual);
+        while (level.size() > 1)
+        {
+            size_t num = 0;
+            for (size_t i = 0; i + 1 < level.size(); i += 2) level[num++] = make_and(level[i], level[i + 1]);
+            if (level.size() % 2 == 1) level[num++] = level.back();
+            level.resize(num);
+        }
+        res = level[0];
     }
-    big_clause.push_back(res);
-    add_clause(big_clause);
+    else
+    {
+        std::vector<var_t> big_clause;
+        big_clause.reserve(actual.size() + 1);
+        res = new_var();
+        for (var_t in_var : actual)
+        {
+            add_clause(+in_var, -res);
+            big_clause.push_back(-in_var);
+        }
+        big_clause.push_back(res);
+        add_clause(big_clause);
+    }
+    count_emitted(gate_kind_t::AND_N, nvars_start, nclauses_start);
+
+    register_and_n(actual, res);
     return res;
 }
 
 var_t Solver::make_or(const var_t a, const var_t b)
 {
+    const call_scope_t scope(*this);
+    if (scope.traced()) trace_lits(trace_op_t::OR, {a, b});
     return -make_and(-a, -b);
 }
 
 var_t Solver::make_or(const std::vector<var_t>& ins)
 {
+    const call_scope_t scope(*this);
+    if (scope.traced()) trace_lits(trace_op_t::OR_N, ins.data(), ins.size());
     std::vector<var_t> neg_ins;
     neg_ins.reserve(ins.size());
     for(var_t in_var : ins) neg_ins.push_back(-in_var);
@@ -75,16 +334,22 @@ var_t Solver::make_or(const std::vector<var_t>& ins)
 
 var_t Solver::make_xor(var_t a, var_t b)
 {
+    const call_scope_t scope(*this);
+    if (scope.traced()) trace_lits(trace_op_t::XOR, {a, b});
+    a = substitute(a), b = substitute(b);
     var_t c = simplify_xor(a, b);
     if (c != var_t::ILLEGAL) return c;
+    if (m_deferred)
+    {
+        c = rewrite_xor(a, b);
+        if (c != var_t::ILLEGAL) return c;
+    }
 
-    // Add the clauses for constraining the variables
+    const int nvars_start = num_vars();
+    const int nclauses_start = m_num_clauses;
     c = new_var();
-    add_clause(-a, -b, -c);
-    add_clause(+a, +b, -c);
-    add_clause(-a, +b, +c);
-    add_clause(+a, -b, +c);
-    m_state = STATE_INPUT;
+    define_gate(gate_kind_t::XOR, {a, b, var_t::ZERO}, c);
+    count_emitted(gate_kind_t::XOR, nvars_start, nclauses_start);
 
     register_xor(a, b, c);
     return c;
@@ -92,124 +357,121 @@ var_t Solver::make_xor(var_t a, var_t b)
 
 var_t Solver::make_xor(const std::vector<var_t>& ins)
 {
-    std::vector<var_t> actual;
-    uint32_t num_negs = 0;
-    for(var_t v: ins)
+    const call_scope_t scope(*this);
+    if (scope.traced()) trace_lits(trace_op_t::XOR_N, ins.data(), ins.size());
+    std::vector<var_t> actual(ins);
+    for (var_t& x : actual) x = substitute(x);
+    bool neg;
+    const var_t known = simplify_xor_n(actual, neg);
+    if (known != var_t::ILLEGAL) return known;
+    if (actual.size() == 2)
     {
-        if (v == var_t::ZERO)
-            continue;
-        else if (v == var_t::ONE)
-            num_negs += 1;
-        else
+        stats_of(gate_kind_t::XOR_N).folds += 1;
+        const var_t res = make_xor(actual[0], actual[1]);
+        return neg ? -res : +res;
+    }
+    const std::vector<var_t> key(actual);
+
+    const int nvars_start = num_vars();
+    const int nclauses_start = m_num_clauses;
+    const std::pair<xor_shape_t, uint32_t> encoding = xor_encoding(actual.size());
+    const uint32_t width = encoding.second;
+    std::vector<var_t> chunk, next;
+    auto encode_chunk = [&]() {
+        const var_t res = new_var();
+        encode_xor_chunk(chunk, res);
+        chunk.clear();
+        return res;
+    };
+    if (encoding.first == xor_shape_t::CHAIN)
+    {
+        // The first chunk takes width inputs, every later one its predecessor and width - 1 inputs
+        size_t i = std::min<size_t>(width, actual.size());
+        chunk.assign(actual.begin(), actual.begin() + i);
+        var_t res = encode_chunk();
+        while (i < actual.size())
         {
-            if (is_negated(v))
-                num_negs += 1;
-            actual.push_back(abs_var_t(v));
+            const size_t end = std::min<size_t>(actual.size(), i + width - 1);
+            chunk.assign(1, res);
+            chunk.insert(chunk.end(), actual.begin() + i, actual.begin() + end);
+            res = encode_chunk();
+            i = end;
         }
+        actual.assign(1, res);
     }
-    if (actual.empty()) return (num_negs % 2 == 0) ? var_t::ZERO : var_t::ONE;
-
-    const uint32_t NUM_EXP = 7;
-
-    std::vector<var_t> n_actual;
-    std::vector<var_t> clause(NUM_EXP + 1, var_t::ZERO);
-
-    while (actual.size() != 1)
+    else
     {
-        n_actual.clear();
-        for (uint32_t i = 0; i < actual.size(); i += NUM_EXP)
+        while (actual.size() != 1)
         {
-            if (i == actual.size() - 1)
-            {
-                n_actual.push_back(actual.at(i));
-                continue;
-            }
-            var_t res = new_var();
-
-            for (uint32_t comb = 0; comb < (1 << NUM_EXP); comb++)
+            next.clear();
+            for (size_t i = 0; i < actual.size(); i += width)
             {
-                uint32_t popcnt = 0;
-                for (uint32_t j = 0; j < NUM_EXP; j++)
-                {
-                    const uint32_t sign = (comb >> j) & 1;
-                    popcnt += sign;
-                    const var_t v = i+j < actual.size() ? actual.at(i+j) : var_t::ZERO;
-                    clause.at(j) = sign ? -v : v;
-                }
-                clause.at(NUM_EXP) = (popcnt % 2 == 0) ? -res : res;
-                add_clause(clause);
+                chunk.assign(actual.begin() + i, actual.begin() + std::min(actual.size(), i + width));
+                if (chunk.size() == 1) next.push_back(chunk[0]);
+                else next.push_back(encode_chunk());
             }
-            n_actual.push_back(res);
+            actual.swap(next);
         }
-        actual = n_actual;
     }
 
-    return (num_negs % 2 == 0) ? actual.at(0) : -actual.at(0);
+    count_emitted(gate_kind_t::XOR_N, nvars_start, nclauses_start);
+
+    register_xor_n(key, actual.at(0));
+    return neg ? -actual.at(0) : actual.at(0);
 }
 
 var_t Solver::make_mux(var_t s, var_t t, var_t e)
 {
+    const call_scope_t scope(*this);
+    if (scope.traced()) trace_lits(trace_op_t::MUX, {s, t, e});
+    s = substitute(s), t = substitute(t), e = substitute(e);
     var_t r = simplify_mux(s, t, e);
     if (r != var_t::ILLEGAL) return r;
 
+    const int nvars_start = num_vars();
+    const int nclauses_start = m_num_clauses;
     r = new_var();
-    add_clause(-s, -t, +r);
-    add_clause(-s, +t, -r);
-    add_clause(+s, -e, +r);
-    add_clause(+s, +e, -r);
-    add_clause(-t, -e, +r);
-    add_clause(+t, +e, -r);
-    m_state = STATE_INPUT;
+    define_gate(gate_kind_t::MUX, {s, t, e}, r);
+    count_emitted(gate_kind_t::MUX, nvars_start, nclauses_start);
 
     register_mux(s, t, e, r);
     return r;
 }
 
-// implementation of https://link.springer.com/content/pdf/10.1007%2F11564751_73.pdf
-var_t Solver::make_at_most(const std::vector<var_t>& ins, uint32_t k)
+var_t Solver::make_xor3(var_t a, var_t b, var_t c)
 {
-    if (k == 0) { return -make_or(ins); }
-    if (k >= ins.size()) return var_t::ONE;
-
-    const uint32_t nvars_start = num_vars();
-
-    std::vector<var_t> s;
-    s.resize(k, var_t::ZERO);
-
-    std::vector<var_t> ns;
-    ns.reserve(k);
-
-    std::vector<var_t> v;
-    v.reserve(ins.size());
-
-    // Iterate over all but the last input
-    for (uint32_t i = 0; i < ins.size() - 1; i++)
-    {
-        ns.clear(); ns.resize(k, var_t::ILLEGAL);
-        ns[0] = make_or(ins[i], s[0]);
-        for (uint32_t j = 1; j < k; j++)
-        {
-            ns[j] = make_or(s[j], make_and(s[j-1], ins[i]));
-        }
-        v.push_back(make_and(ins[i], s[k-1]));
-        s = ns;
-    }
-
-    // compute v for last input
-    v.push_back(make_and(ins[ins.size() - 1], s[k-1]));
-
-    var_t res = -make_or(v);
+    const call_scope_t scope(*this);
+    if (scope.traced()) trace_lits(trace_op_t::XOR3, {a, b, c});
+    a = substitute(a), b = substitute(b), c = substitute(c);
+    var_t r = simplify_xor3(a, b, c);
+    if (r != var_t::ILLEGAL) return r;
 
-    const uint32_t nvars_end = num_vars();
-    DEBUG(1) << "at-most constraint added " << nvars_end - nvars_start << " new variables" << std::endl;
+    const int nvars_start = num_vars();
+    const int nclauses_start = m_num_clauses;
+    r = new_var();
+    define_gate(gate_kind_t::XOR3, {a, b, c}, r);
+    count_emitted(gate_kind_t::XOR3, nvars_start, nclauses_start);
 
-    return res;
+    register_xor3(a, b, c, r);
+    return r;
 }
 
-var_t Solver::make_at_least(const std::vector<var_t>& ins, uint32_t k)
+var_t Solver::make_maj(var_t a, var_t b, var_t c)
 {
-    if (k == 0) return var_t::ONE;
-    return -make_at_most(ins, k - 1);
+    const call_scope_t scope(*this);
+    if (scope.traced()) trace_lits(trace_op_t::MAJ, {a, b, c});
+    a = substitute(a), b = substitute(b), c = substitute(c);
+    var_t r = simplify_maj(a, b, c);
+    if (r != var_t::ILLEGAL) return r;
+
+    const int nvars_start = num_vars();
+    const int nclauses_start = m_num_clauses;
+    r = new_var();
+    define_gate(gate_kind_t::MAJ, {a, b, c}, r);
+    count_emitted(gate_kind_t::MAJ, nvars_start, nclauses_start);
+
+    register_maj(a, b, c, r);
+    return r;
 }
 
 int Solver::check_timed_helper(void* state)
@@ -220,7 +482,7 @@ int Solver::check_timed_helper(void* state)
     return current >= *end;
 }
 
-Solver::state_t Solver::check_timed(double num_seconds) noexcept
+Solver::state_t Solver::check_timed(double num_seconds)
 {
     const auto start{std::chrono::steady_clock::now()};
     auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
@@ -228,22 +490,79 @@ Solver::state_t Solver::check_timed(double num_seconds) noexcept
     );
     const auto end = start + duration;
     void* state = (void*)(&end);
+    if (tracing())
+    {
+        m_trace->write_op(trace_op_t::CHECK_TIMED);
+        m_trace->write_uint(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count()));
+    }
+    emit_xors();
+    emit_deferred();
+    flush();
     ipasir_set_terminate(m_solver, state, Solver::check_timed_helper);
     m_state = static_cast<state_t>(ipasir_solve(m_solver));
+    m_node_values.clear();
     ipasir_set_terminate(m_solver, nullptr, nullptr);
+    m_solved_since_harvest = true;
+    if (m_harvest_fixed) harvest_fixed();
     return m_state;
 }
 
-Solver::state_t Solver::check() noexcept
+Solver::state_t Solver::check()
 {
+    if (tracing()) m_trace->write_op(trace_op_t::CHECK);
+    emit_xors();
+    emit_deferred();
+    flush();
     m_state = static_cast<state_t>(ipasir_solve(m_solver));
+    m_node_values.clear();
+    m_solved_since_harvest = true;
+    if (m_harvest_fixed) harvest_fixed();
     return m_state;
 }
 
+size_t Solver::harvest_fixed()
+{
+    size_t num = 0;
+#ifdef CXXSAT_BACKEND_CADICAL
+    // Nothing new is fixed without solving
+    if (!m_solved_since_harvest) return 0;
+    m_solved_since_harvest = false;
+    for (; m_num_harvest_vars < num_vars(); m_num_harvest_vars++) m_unfixed.push_back(m_num_harvest_vars + 1);
+
+    auto* backend = static_cast<CCaDiCaL*>(m_solver);
+    size_t kept = 0;
+    for (const int32_t v : m_unfixed)
+    {
+        // Constant and substituted variables are done, their representatives are queried instead
+        const var_t x = as_var(v);
+        if (substitute(x) != x) continue;
+        m_unfixed[kept++] = v;
+        // Half-encoded gates may be fixed against their function
+        const size_t var = static_cast<size_t>(v);
+        if (var < m_nodes.size() && m_nodes[var].state != node_state_t::NONE &&
+            m_nodes[var].emitted != POLARITY_BOTH) continue;
+        const int fixed = ccadical_fixed(backend, v);
+        if (fixed == 0) continue;
+        // The backend already has the unit, only the gate constructors need to know it
+        assert_unit(fixed > 0 ? x : -x);
+        kept -= 1;
+        num += 1;
+    }
+    m_unfixed.resize(kept);
+    DEBUG(2) << "harvested " << num << " fixed literals" << std::endl;
+#endif
+    return num;
+}
+
 bool Solver::value(var_t a)
 {
     Assert(m_state == STATE_SAT, REQUIRE_SAT);
+    // Substituted variables may not occur in the clauses passed to the backend
+    a = substitute(a);
     if (a == var_t::ZERO) return false;
     if (a == var_t::ONE) return true;
+    const size_t var = static_cast<size_t>(as_int(abs_var_t(a)));
+    if (var < m_nodes.size() && m_nodes[var].state != node_state_t::NONE && m_nodes[var].emitted != POLARITY_BOTH)
+        return node_value(static_cast<int32_t>(var)) != is_negated(a);
     return ipasir_val(m_solver, as_int(a)) > 0;
 }
\ No newline at end of file
@@ -4,6 +4,13 @@
 #include "debug.h"
 #include "vars.h"
 #include "VarManager.h"
+#include "Trace.h"
+#include "XorSystem.h"
+#include <initializer_list>
+#include <array>
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
 
 extern "C" {
 #include "ipasir.h"
@@ -12,8 +19,95 @@ extern "C" {
 namespace cxxsat {
 
 constexpr const char* REQUIRE_SAT = "Solver must be in STATE_SAT state";
+constexpr const char* UNTERMINATED_CLAUSE = "Clause literals must be terminated with 0";
+constexpr const char* ILLEGAL_OFFSETS = "Clause offsets must be non-decreasing and inside the literals";
+constexpr const char* NO_FIXED_ENCODING = "Only binary and ternary gates have a fixed encoding";
+constexpr const char* ILLEGAL_XOR_WIDTH = "XOR chunk width must be 0 or between 2 and MAX_XOR_WIDTH";
+constexpr const char* ILLEGAL_AMO_ENCODING = "At-most-one encoding must be one of amo_encoding_t";
+
+/// Number of buffered literals after which clauses are passed to the backend
+constexpr size_t CLAUSE_BUFFER_SIZE = 1 << 16;
+/// Largest number of inputs of a chunk of a wide XOR, which has 2^width clauses
+constexpr uint32_t MAX_XOR_WIDTH = 12;
+
+/// Available encodings for cardinality constraints
+enum class card_encoding_t {
+    AUTO,             ///< Pick the cheapest encoding based on the number of inputs and the bound
+    SEQUENTIAL,       ///< Sinz's sequential counter built from cached gates
+    TOTALIZER,        ///< Bailleux and Boufkhad's totalizer with outputs truncated at k + 1
+    MODULO_TOTALIZER, ///< Ogawa et al.'s modulo totalizer with unary quotient and remainder
+    SORTING_NETWORK   ///< Batcher's odd-even merge sort with unused comparators pruned
+};
+
+/// Available encodings for at-most-one constraints, all emitted as raw clauses
+enum class amo_encoding_t {
+    AUTO,      ///< Pick the encoding with the fewest estimated clauses and variables
+    PAIRWISE,  ///< One binary clause per pair of inputs
+    LADDER,    ///< Sequential counter with one prefix variable per input
+    COMMANDER, ///< Klieber and Kwon's commander variables over groups of three
+    PRODUCT,   ///< Chen's product encoding over a grid of row and column variables
+    BIMANDER   ///< Nguyen and Mai's binary commanders over pairs of inputs
+};
+
+/// Available encodings for pseudo-Boolean constraints
+enum class pb_encoding_t {
+    AUTO,                  ///< Use a BDD unless its estimated size is too large, then use adders
+    BDD,                   ///< Reduced BDD over the inputs, built from cached MUX gates
+    GENERALIZED_TOTALIZER, ///< Totalizer over the distinct partial sums of the weights
+    ADDER                  ///< Adder network summing the weights bit by bit, built from cached gates
+};
+
+/// Shapes of the chunks that encode wide XORs
+enum class xor_shape_t {
+    AUTO,  ///< Pick the shape and the chunk width with the lowest cost for the number of inputs
+    CHAIN, ///< Every chunk after the first takes the output of the one before it
+    TREE   ///< Every chunk combines the outputs of the level below it
+};
+
+/// Order of literals in simplified clauses: by variable, with x before -x and the constants
+/// last, so repeated and complementary literals become neighbours
+inline bool clause_less(var_t a, var_t b) noexcept
+{
+    const uint32_t ka = (static_cast<uint32_t>(as_int(abs_var_t(a))) << 1) | is_negated(a);
+    const uint32_t kb = (static_cast<uint32_t>(as_int(abs_var_t(b))) << 1) | is_negated(b);
+    return ka < kb;
+}
+
+/// Sorts \a lits by clause_less with an odd-even transposition network, which the compiler
+/// unrolls into branch-free compare-exchanges for the small sizes of gate clauses
+template<size_t N>
+inline void sort_network(std::array<var_t, N>& lits) noexcept
+{
+    for (size_t round = 0; round < N; round++)
+    {
+        for (size_t i = round & 1; i + 1 < N; i += 2)
+        {
+            const var_t a = lits[i], b = lits[i + 1];
+            const bool swap = clause_less(b, a);
+            lits[i] = swap ? b : a;
+            lits[i + 1] = swap ? a : b;
+        }
+    }
+}
+
+/// Sorts lits[0..size) by clause_less, with insertion sort for short clauses
+inline void sort_clause(var_t* lits, size_t size)
+{
+    if (size > 16) { std::sort(lits, lits + size, clause_less); return; }
+    for (size_t i = 1; i < size; i++)
+    {
+        const var_t x = lits[i];
+        size_t j = i;
+        for (; j > 0 && clause_less(x, lits[j - 1]); j--) lits[j] = lits[j - 1];
+        lits[j] = x;
+    }
+}
+
+class Totalizer;
+class DimacsWriter;
 
 class Solver : public VarManager {
+    friend class Totalizer;
 public:
     enum state_t {STATE_SAT = 10, STATE_UNSAT = 20, STATE_INPUT = 0};
 private:
@@ -25,19 +119,170 @@ private:
     void* m_solver;
     /// Output stream for logging formula
     std::ostream* m_output;
-
-    /// Internal ipasir_add forwarding
+    /// DIMACS writer receiving all flushed clauses
+    DimacsWriter* m_writer;
+    /// Literals of complete clauses not yet passed to the backend, each terminated by 0
+    std::vector<int32_t> m_buffer;
+    /// Literals of flushed clauses kept for gate detection while recording
+    std::vector<int32_t> m_recorded;
+    bool m_recording;
+    /// Scratch space for sorting clauses given as vectors
+    std::vector<var_t> m_clause;
+    /// Literals of all clauses added while the clause set is enabled, and the offset and
+    /// size of each clause indexed by its hash
+    bool m_clause_set_enabled;
+    std::vector<var_t> m_clause_arena;
+    std::unordered_multimap<uint64_t, std::pair<size_t, size_t>> m_clause_set;
+    /// Trace receiving the public calls, and the nesting depth of the current call
+    TraceWriter* m_trace;
+    uint32_t m_depth;
+    /// True if the literals fixed by the backend are imported after every check
+    bool m_harvest_fixed;
+    /// Variables that may still become fixed, the number of variables already added to them,
+    /// and whether the backend solved since the last harvest
+    std::vector<int32_t> m_unfixed;
+    int32_t m_num_harvest_vars;
+    bool m_solved_since_harvest;
+
+    /// States of the gates created in deferred mode
+    enum class node_state_t : uint8_t {
+        NONE,    ///< The variable is not the output of a deferred gate
+        PENDING, ///< The clauses of the needed polarities are emitted by the next check
+        DORMANT, ///< Not needed by the emitted clauses, because it was inlined into its only user
+                 ///< or recorded in lazy mode. Becomes pending once referenced
+        EMITTED  ///< The clauses of the needed polarities have been emitted
+    };
+    /// Gate of a variable created in deferred mode, binary gates leave the last input unused
+    struct node_t {
+        std::array<var_t, 3> ins;
+        gate_kind_t kind;
+        node_state_t state;
+        /// Number of references by other deferred gates, clauses and assumptions
+        uint32_t refs;
+        /// Polarities the references need and polarities whose clauses have been emitted
+        uint8_t needed;
+        uint8_t emitted;
+    };
+    /// Halves of the definition of a gate r: the positive one holds the clauses with -r, which
+    /// are needed where r occurs positively, and the negative one those with +r
+    static constexpr uint8_t POLARITY_POS = 1;
+    static constexpr uint8_t POLARITY_NEG = 2;
+    static constexpr uint8_t POLARITY_BOTH = 3;
+    /// True if new gates are kept as nodes and their clauses emitted by the next check
+    bool m_deferred;
+    /// True if new nodes stay dormant until a clause or an assumption references them
+    bool m_lazy;
+    /// True if references only need the clauses of their own polarity
+    bool m_polarity;
+    /// Deferred gates indexed by their output variable, empty until deferred mode is first used
+    std::vector<node_t> m_nodes;
+    /// Outputs of the pending gates
+    std::vector<int32_t> m_pending;
+    /// Values in the current model of deferred gates without emitted clauses, 0 if not evaluated yet
+    std::vector<int8_t> m_node_values;
+
+    /// XOR constraints added since the last check, and all independent ones added before
+    std::vector<parity_t> m_xors;
+    XorSystem m_xor_system;
+    size_t m_num_redundant_xors;
+    /// Shape and chunk width of wide XORs, a width of 0 is chosen by the cost model
+    xor_shape_t m_xor_shape;
+    uint32_t m_xor_width;
+
+    /// Marks a public call that may call other public functions, only calls at depth 0 are traced
+    class call_scope_t {
+    private:
+        Solver& m_solver;
+    public:
+        explicit call_scope_t(Solver& solver) noexcept : m_solver(solver) { m_solver.m_depth += 1; }
+        ~call_scope_t() { m_solver.m_depth -= 1; }
+        /// Returns true if the call has to be traced
+        inline bool traced() const noexcept { return m_solver.m_trace != nullptr && m_solver.m_depth == 1; }
+    };
+    /// Returns true if a call outside of any other call has to be traced
+    inline bool tracing() const noexcept { return m_trace != nullptr && m_depth == 0; }
+    /// Traces the allocation of \a number variables
+    void trace_new_vars(int number);
+    /// Traces an operation over a fixed number of literals
+    void trace_lits(trace_op_t op, std::initializer_list<var_t> lits);
+    /// Traces an operation over the literals lits[0..size), preceded by their count
+    void trace_lits(trace_op_t op, const var_t* lits, size_t size);
+    /// Traces an operation over a cardinality or pseudo-Boolean constraint, weights may be empty
+    void trace_constraint(trace_op_t op, const std::vector<var_t>& ins, const std::vector<int64_t>& weights,
+                          int64_t bound, uint32_t encoding);
+
+    /// Internal literal buffering
     inline void add(var_t x);
-
-    /// Performs checks whether the clause is a tautology, or contains illegal literals
-    template<typename... Ts>
-    bool check_clause_inner(var_t head, Ts... tail);
-
-    /// Recursive template function that simplifies and adds a clause into the solver
-    template<typename... Ts>
-    void add_clause_inner(var_t head, Ts... tail);
+    /// Terminates the current clause, flushing the buffer once it is full
+    inline void end_clause();
+    /// Writes the buffered clauses to the output stream and the DIMACS writer
+    void write_buffer();
+    /// Validates and buffers the clause lits[begin..end), which must not contain 0
+    void add_raw_clause(const int32_t* lits, size_t begin, size_t end);
+
+    /// Adds the clause lits[0..size) sorted by clause_less, dropping it if it is satisfied,
+    /// a tautology or a known duplicate, and removing ZERO and repeated literals. Units are
+    /// recorded for substitution
+    inline void add_sorted_clause(var_t* lits, size_t size);
+    /// Inserts the simplified clause lits[0..size) into the clause set, returns false if it is present
+    bool insert_clause_set(const var_t* lits, size_t size);
 
     static int check_timed_helper(void* state);
+
+    /// Adds the variables and clauses created since the given counts to the counters of \a kind
+    inline void count_emitted(gate_kind_t kind, int nvars_start, int nclauses_start) noexcept;
+
+    /// Adds the clauses of r == kind(ins)
+    void encode_gate(gate_kind_t kind, const std::array<var_t, 3>& ins, var_t r,
+                     uint8_t polarities = POLARITY_BOTH);
+    /// Adds the clauses of r == kind(ins), or keeps the gate as a node in deferred mode
+    void define_gate(gate_kind_t kind, const std::array<var_t, 3>& ins, var_t r);
+    /// Counts a reference to \a x by a clause or an assumption, which makes the node pending
+    /// if the polarity of \a x has not been needed yet
+    inline void use_node(var_t x);
+    /// Returns the node defining the variable of \a x if it is a deferred gate of \a kind
+    const node_t* node_of(var_t x, gate_kind_t kind) const;
+    /// Two-level rewriting of AND(a, b) and XOR(a, b) over deferred nodes, returns ILLEGAL if no rule applies
+    var_t rewrite_and(var_t a, var_t b);
+    var_t rewrite_xor(var_t a, var_t b);
+    /// Emits the clauses of the pending node of \a var for its newly needed polarities, inlining
+    /// the single-use ANDs below an AND. The nodes referenced by these clauses become pending in turn
+    void emit_node(int32_t var);
+    /// Evaluates the node of \a var over the current model
+    bool node_value(int32_t var);
+    /// Adds the clauses of r == XOR(ins)
+    void encode_xor_chunk(const std::vector<var_t>& ins, var_t r);
+    /// Adds XOR(vars) == rhs for distinct positive variables
+    void encode_parity(const std::vector<var_t>& vars, bool rhs);
+
+    /// Picks the cardinality encoding with the smallest estimated number of clauses
+    static card_encoding_t choose_card_encoding(uint32_t n, uint32_t k);
+    /// Encodings of AT-MOST(ins, k) that assume 0 < k < ins.size()
+    var_t make_at_most_sequential(const std::vector<var_t>& ins, uint32_t k);
+    var_t make_at_most_totalizer(const std::vector<var_t>& ins, uint32_t k);
+    var_t make_at_most_modulo_totalizer(const std::vector<var_t>& ins, uint32_t k);
+    var_t make_at_most_sorting_network(const std::vector<var_t>& ins, uint32_t k);
+    /// Defines the unary digits r[from..] as the sum of the unary numbers \a a and \a b
+    void encode_unary_sum(const std::vector<var_t>& a, const std::vector<var_t>& b,
+                          const std::vector<var_t>& r, uint32_t from);
+
+    /// Picks the at-most-one encoding with the smallest estimated number of clauses and variables
+    static amo_encoding_t choose_amo_encoding(uint32_t n);
+    /// Adds the clauses of act -> AT-MOST-ONE(ins) for substituted non-constant inputs
+    void encode_amo(const std::vector<var_t>& ins, amo_encoding_t encoding, var_t act);
+    void encode_amo_pairwise(const std::vector<var_t>& ins, var_t act);
+    void encode_amo_ladder(const std::vector<var_t>& ins, var_t act);
+    void encode_amo_commander(const std::vector<var_t>& ins, var_t act);
+    void encode_amo_product(const std::vector<var_t>& ins, var_t act);
+    void encode_amo_bimander(const std::vector<var_t>& ins, var_t act);
+    /// Substitutes \a ins and drops the ZERO inputs, returns the number of ONE inputs
+    uint32_t amo_inputs(const std::vector<var_t>& ins, std::vector<var_t>& actual);
+
+    /// Encodings of SUM(weights * ins) <= bound that assume normalized positive weights,
+    /// sorted in descending order and no larger than bound + 1
+    var_t make_pb_le_bdd(const std::vector<var_t>& ins, const std::vector<int64_t>& weights, int64_t bound);
+    var_t make_pb_le_totalizer(const std::vector<var_t>& ins, const std::vector<int64_t>& weights, int64_t bound);
+    var_t make_pb_le_adder(const std::vector<var_t>& ins, const std::vector<int64_t>& weights, int64_t bound);
 public:
     /// Returns the number of currently added clauses
     inline int num_clauses() const noexcept { return m_num_clauses; };
@@ -52,12 +297,39 @@ public:
     var_t make_xor(var_t a, var_t b) override;
     /// Creates a new variable representing MUX(s, t, e)
     var_t make_mux(var_t s, var_t t, var_t e) override;
+    /// Creates a new variable representing XOR(a, b, c)
+    var_t make_xor3(var_t a, var_t b, var_t c) override;
+    /// Creates a new variable representing MAJ(a, b, c)
+    var_t make_maj(var_t a, var_t b, var_t c) override;
 
     var_t make_and(const std::vector<var_t>& ins);
     var_t make_or(const std::vector<var_t>& ins);
     var_t make_xor(const std::vector<var_t>& ins);
-    var_t make_at_most(const std::vector<var_t>& ins, uint32_t k);
-    var_t make_at_least(const std::vector<var_t>& ins, uint32_t k);
+    /// Creates a new variable representing SUM(ins) <= k
+    var_t make_at_most(const std::vector<var_t>& ins, uint32_t k,
+                       card_encoding_t encoding = card_encoding_t::AUTO);
+    /// Creates a new variable representing SUM(ins) >= k
+    var_t make_at_least(const std::vector<var_t>& ins, uint32_t k,
+                        card_encoding_t encoding = card_encoding_t::AUTO);
+    /// Creates a new variable representing SUM(ins) <= 1
+    var_t make_at_most_one(const std::vector<var_t>& ins, amo_encoding_t encoding = amo_encoding_t::AUTO);
+    /// Creates a new variable representing SUM(ins) == 1
+    var_t make_exactly_one(const std::vector<var_t>& ins, amo_encoding_t encoding = amo_encoding_t::AUTO);
+    /// Adds the clauses of act -> SUM(ins) <= 1, which are cheaper than those of make_at_most_one
+    void add_at_most_one(const std::vector<var_t>& ins, amo_encoding_t encoding = amo_encoding_t::AUTO,
+                         var_t act = var_t::ONE);
+    /// Adds the clauses of act -> SUM(ins) == 1
+    void add_exactly_one(const std::vector<var_t>& ins, amo_encoding_t encoding = amo_encoding_t::AUTO,
+                         var_t act = var_t::ONE);
+    /// Creates a new variable representing SUM(weights * ins) <= bound
+    var_t make_pb_le(const std::vector<var_t>& ins, const std::vector<int64_t>& weights, int64_t bound,
+                     pb_encoding_t encoding = pb_encoding_t::AUTO);
+    /// Creates a new variable representing SUM(weights * ins) >= bound
+    var_t make_pb_ge(const std::vector<var_t>& ins, const std::vector<int64_t>& weights, int64_t bound,
+                     pb_encoding_t encoding = pb_encoding_t::AUTO);
+    /// Creates a new variable representing SUM(weights * ins) == bound
+    var_t make_pb_eq(const std::vector<var_t>& ins, const std::vector<int64_t>& weights, int64_t bound,
+                     pb_encoding_t encoding = pb_encoding_t::AUTO);
 
 
     /// Public template function for adding clauses into the solver
@@ -66,19 +338,108 @@ public:
 
     /// Public function for adding clauses from vectors into the solver
     inline void add_clause(const std::vector<var_t>& clause);
+    /// Adds the clauses of a == b and substitutes one for the other from now on
+    void add_equivalence(var_t a, var_t b);
+
+    /// Adds \a size literals holding clauses in DIMACS form, each terminated by 0.
+    /// Literals may also be the integer values of var_t::ZERO and var_t::ONE
+    void add_clauses(const int32_t* lits, size_t size);
+    /// Adds \a num_clauses clauses, where clause i consists of lits[offsets[i]..offsets[i + 1])
+    void add_clauses(const int32_t* lits, const size_t* offsets, size_t num_clauses);
+    /// Passes all buffered clauses to the backend, the output stream and the DIMACS writer.
+    /// The destructor still writes the buffered clauses to the stream and the writer
+    void flush();
+
+    /// Allocates \a number many solver variables and returns the first one
+    inline var_t new_vars(int number);
+    /// Allocates and returns a new solver variable
+    inline var_t new_var() { return new_vars(1); }
+
+    /// Starts or stops rejecting clauses that were already added through add_clause since
+    /// the set was enabled. Stopping drops the set, which stores a copy of every clause
+    void set_clause_set(bool enable);
+    /// Returns the number of clauses in the clause set
+    inline size_t clause_set_size() const noexcept { return m_clause_set.size(); }
+
+    /// Starts or stops keeping the added clauses for gate detection, stopping drops them
+    void set_recording(bool enable);
+    /// Returns true while added clauses are kept for gate detection
+    inline bool is_recording() const noexcept { return m_recording; }
+    using VarManager::detect_gates;
+    /// Detects gates in the clauses kept since recording started or since the last detection
+    size_t detect_gates();
+
+    /// Starts or stops deferred mode, in which AND, XOR, MUX, XOR3 and MAJ gates are kept as
+    /// nodes and their clauses are only emitted by the next check. New ANDs and XORs are
+    /// rewritten with the nodes of their inputs, and single-use ANDs below an AND are emitted
+    /// as one n-ary AND. Stopping emits all pending nodes
+    void set_deferred(bool enable);
+    /// Returns true in deferred mode
+    inline bool is_deferred() const noexcept { return m_deferred; }
+    /// Starts or stops lazy mode, a deferred mode in which nodes are only emitted once a clause
+    /// or an assumption references them, together with the nodes they depend on. Gates that
+    /// are never referenced do not reach the backend. Starting enables deferred mode
+    void set_lazy(bool enable);
+    /// Returns true in lazy mode
+    inline bool is_lazy() const noexcept { return m_lazy; }
+    /// Starts or stops polarity mode, a lazy mode with the encoding of Plaisted and Greenbaum.
+    /// A node referenced only positively gets the clauses of r -> f, one referenced only
+    /// negatively those of f -> r, and the other half follows once a reference needs it.
+    /// Values of half-encoded gates are computed from their inputs. Starting enables lazy mode
+    void set_polarity(bool enable);
+    /// Returns true in polarity mode
+    inline bool is_polarity() const noexcept { return m_polarity; }
+    /// Emits the clauses of all pending deferred gates, which every check does first
+    void emit_deferred();
+    /// Returns the number of deferred gates whose clauses have not been emitted
+    inline size_t num_pending() const noexcept { return m_pending.size(); }
+
+    /// Adds the constraint XOR(lits) == rhs. The constraints are collected until the next check,
+    /// which reduces each against all earlier ones by Gauss-Jordan elimination. Implied ones are
+    /// dropped, and the units and equivalences of the system are added as clauses. The others are
+    /// encoded with make_xor
+    void add_xor(const std::vector<var_t>& lits, bool rhs = true);
+    /// Reduces and adds the collected XOR constraints, which every check does first
+    void emit_xors();
+    /// Sets how make_xor splits XORs over more inputs than fit a single chunk. A width of 0 or
+    /// the AUTO shape leave the choice to a cost model over literals and auxiliary variables
+    void set_xor_encoding(xor_shape_t shape, uint32_t width = 0);
+    /// Returns the shape and the chunk width used for an XOR over \a num_ins inputs
+    std::pair<xor_shape_t, uint32_t> xor_encoding(size_t num_ins) const;
+    /// Returns the number of XOR constraints dropped because earlier ones implied them
+    inline size_t num_redundant_xors() const noexcept { return m_num_redundant_xors; }
+
+    /// Starts or stops importing the literals fixed by the backend after every check
+    void set_harvest_fixed(bool enable) { m_harvest_fixed = enable; }
+    /// Returns true if the literals fixed by the backend are imported after every check
+    inline bool is_harvesting_fixed() const noexcept { return m_harvest_fixed; }
+    /// Substitutes the variables the backend has fixed at the root level by constants and
+    /// returns their number. Only CaDiCaL exposes its fixed literals, other backends yield 0.
+    /// Only variables not yet constant or substituted are queried, and only after a check
+    size_t harvest_fixed();
 
     /// Public function for adding clauses from vectors into the solver
     inline void assume(var_t ass);
 
-    state_t check_timed(double num_seconds) noexcept;
-    /// Main satisfiability checking routine
-    state_t check() noexcept;
+    /// Checks satisfiability with a time limit. Throws if flushing the pending clauses fails
+    state_t check_timed(double num_seconds);
+    /// Main satisfiability checking routine. Throws if flushing the pending clauses fails
+    state_t check();
     /// Return the value assigned to variable \a a
     bool value(var_t a);
 
-    /// Set the output stream
-    void set_stream(std::ostream* out) { m_output = out; }
+    /// Set the output stream receiving all clauses added from now on. The stream must stay
+    /// open until it is cleared or the solver is destroyed, which write the pending clauses
+    void set_stream(std::ostream* out) { flush(); m_output = out; }
     void clear_stream() { set_stream(nullptr); }
+    /// Set the DIMACS writer receiving all clauses added from now on. The writer must stay
+    /// open until it is cleared or the solver is destroyed, which write the pending clauses
+    void set_writer(DimacsWriter* writer) { flush(); m_writer = writer; }
+    void clear_writer() { set_writer(nullptr); }
+    /// Set the trace receiving all public calls that create variables, gates or clauses, or
+    /// that check satisfiability. The trace must stay open until it is cleared
+    void set_trace(TraceWriter* trace) { m_trace = trace; }
+    void clear_trace() { set_trace(nullptr); }
 
     auto ands_begin() { return m_and_cache.begin(); }
     auto ands_end()   { return m_and_cache.end(); }
@@ -95,17 +456,56 @@ public:
 
 inline void Solver::add(var_t x)
 {
+    if (!m_nodes.empty()) use_node(x);
     const int y = as_int(x);
-    ipasir_add(m_solver, y);
-    if (m_output != nullptr)
-        (*m_output) << y << ((y != 0) ? ' ' : '\n');
+    m_buffer.push_back(y);
     DEBUG(2) << y << " ";
 }
 
+inline void Solver::end_clause()
+{
+    m_buffer.push_back(0);
+    m_num_clauses += 1;
+    m_state = STATE_INPUT;
+    if (m_buffer.size() >= CLAUSE_BUFFER_SIZE) flush();
+}
+
+inline var_t Solver::new_vars(int number)
+{
+    if (tracing()) trace_new_vars(number);
+    return VarManager::new_vars(number);
+}
+
+inline void Solver::count_emitted(gate_kind_t kind, int nvars_start, int nclauses_start) noexcept
+{
+    gate_stats_t& stats = stats_of(kind);
+    stats.vars += num_vars() - nvars_start;
+    stats.clauses += m_num_clauses - nclauses_start;
+}
+
+inline void Solver::use_node(var_t x)
+{
+    const size_t var = static_cast<size_t>(as_int(abs_var_t(x)));
+    if (var >= m_nodes.size() || m_nodes[var].state == node_state_t::NONE) return;
+    node_t& node = m_nodes[var];
+    if (node.refs != UINT32_MAX) node.refs += 1;
+    const uint8_t polarity = !m_polarity ? POLARITY_BOTH : is_negated(x) ? POLARITY_NEG : POLARITY_POS;
+    if ((node.needed & polarity) == polarity) return;
+    node.needed |= polarity;
+    if (node.state == node_state_t::PENDING) return;
+    node.state = node_state_t::PENDING;
+    m_pending.push_back(static_cast<int32_t>(var));
+}
+
 inline void Solver::assume(var_t ass)
 {
+    const call_scope_t scope(*this);
+    if (scope.traced()) trace_lits(trace_op_t::ASSUME, {ass});
     Assert(is_legal(ass), ILLEGAL_LITERAL);
     Assert(is_known(ass), UNKNOWN_LITERAL);
+    // Substituted variables may not occur in the clauses passed to the backend
+    ass = substitute(ass);
+    if (!m_nodes.empty()) use_node(ass);
     if (ass == var_t::ONE) return;
     if (ass == var_t::ZERO)
     {
@@ -119,70 +519,81 @@ inline void Solver::assume(var_t ass)
     DEBUG(2) << "assuming " << as_int(ass) << std::endl;
 }
 
-template<>
-inline void Solver::add_clause_inner(var_t head)
-{
-    if (head != var_t::ZERO) add(head);
-    add(as_var(0)); // terminate the clause
-    m_num_clauses += 1;
-    m_state = STATE_INPUT;
-}
-
-template<typename... Ts>
-inline void Solver::add_clause_inner(var_t head, Ts... tail)
-{
-    if (head != var_t::ZERO) add(head);
-    add_clause_inner(tail...);
-}
-
 template<typename... Ts>
 inline void Solver::add_clause(var_t head, Ts... tail)
 {
-    if(!check_clause_inner(head, tail...))
+    std::array<var_t, 1 + sizeof...(Ts)> lits = {head, tail...};
+    if (tracing()) trace_lits(trace_op_t::CLAUSE, lits.data(), lits.size());
+    for (const var_t x : lits)
     {
-        DEBUG(2) << "Eliminated clause" << std::endl;
-        return;
+        Assert(is_legal(x), ILLEGAL_LITERAL);
+        Assert(is_known(x), UNKNOWN_LITERAL);
     }
-    DEBUG(2) << "Adding clause: ";
-    add_clause_inner(head,tail...);
-    DEBUG(2) << std::endl;
-}
-
-template<>
-inline bool Solver::check_clause_inner(var_t head)
-{
-    Assert(is_legal(head), ILLEGAL_LITERAL);
-    Assert(is_known(head), UNKNOWN_LITERAL);
-    return (head != var_t::ONE);
-}
-
-template<typename... Ts>
-inline bool Solver::check_clause_inner(var_t head, Ts... tail) {
-    Assert(is_legal(head), ILLEGAL_LITERAL);
-    Assert(is_known(head), UNKNOWN_LITERAL);
-    return (head != var_t::ONE) && check_clause_inner(tail...);
+    for (var_t& x : lits) x = substitute(x);
+    sort_network(lits);
+    add_sorted_clause(lits.data(), lits.size());
 }
 
 inline void Solver::add_clause(const std::vector<var_t>& clause)
 {
+    if (tracing()) trace_lits(trace_op_t::CLAUSE, clause.data(), clause.size());
     for (const var_t x : clause)
     {
         Assert(is_legal(x), ILLEGAL_LITERAL);
         Assert(is_known(x), UNKNOWN_LITERAL);
-        if (x != var_t::ONE) continue;
-        DEBUG(2) << "Eliminated clause" << std::endl;
+    }
+    m_clause.clear();
+    for (const var_t x : clause) m_clause.push_back(substitute(x));
+    sort_clause(m_clause.data(), m_clause.size());
+    add_sorted_clause(m_clause.data(), m_clause.size());
+}
+
+inline void Solver::add_sorted_clause(var_t* lits, size_t size)
+{
+    // Constants sort last, so a clause with ONE ends with it or with ONE followed by ZEROs
+    size_t num = 0;
+    for (size_t i = 0; i < size; i++)
+    {
+        const var_t x = lits[i];
+        if (x == var_t::ONE || (num != 0 && x == -lits[num - 1]))
+        {
+            DEBUG(2) << "Eliminated clause" << std::endl;
+            return;
+        }
+        if (x == var_t::ZERO || (num != 0 && x == lits[num - 1])) continue;
+        lits[num++] = x;
+    }
+    if (m_clause_set_enabled && !insert_clause_set(lits, num))
+    {
+        DEBUG(2) << "Eliminated duplicate clause" << std::endl;
         return;
     }
 
-    for (const var_t x : clause)
-        { if (x != var_t::ZERO) add(x); }
-    add(as_var(0));
-    m_num_clauses += 1;
-    m_state = STATE_INPUT;
+    DEBUG(2) << "Adding clause: ";
+    for (size_t i = 0; i < num; i++) add(lits[i]);
+    end_clause();
+    DEBUG(2) << std::endl;
+    if (num == 1) assert_unit(lits[0]);
 }
 
+/// Solver of the operators in vars.h outside of any SolverScope
 extern Solver* solver;
 
+/// Returns the solver of the innermost SolverScope of the calling thread, or cxxsat::solver
+Solver* current_solver() noexcept;
+
+/// Makes \a solver the target of the operators in vars.h for the calling thread while the scope
+/// lives. Scopes nest, and each thread can build its formulas in its own solver
+class SolverScope {
+private:
+    Solver* m_previous;
+public:
+    explicit SolverScope(Solver& solver) noexcept;
+    ~SolverScope();
+    SolverScope(const SolverScope&) = delete;
+    SolverScope& operator=(const SolverScope&) = delete;
+};
+
 } // namespace cxxsat
 
 #endif // CXXSAT_SOLVER_H
\ No newline at end of file
@@ -0,0 +1,61 @@
+#include "Stats.h"
+
+using cxxsat::gate_kind_t;
+using cxxsat::table_stats_t;
+using cxxsat::solver_stats_t;
+
+const char* cxxsat::to_string(gate_kind_t kind)
+{
+    switch (kind)
+    {
+        case gate_kind_t::AND:   return "and";
+        case gate_kind_t::XOR:   return "xor";
+        case gate_kind_t::MUX:   return "mux";
+        case gate_kind_t::XOR3:  return "xor3";
+        case gate_kind_t::MAJ:   return "maj";
+        case gate_kind_t::AND_N: return "and_n";
+        case gate_kind_t::XOR_N: return "xor_n";
+        case gate_kind_t::CARD:  return "card";
+        case gate_kind_t::PB:    return "pb";
+    }
+    return "unknown";
+}
+
+namespace {
+
+void write_table(std::ostream& out, const char* name, const table_stats_t& table)
+{
+    out << "\"" << name << "\": {\"size\": " << table.size << ", \"capacity\": " << table.capacity
+        << ", \"memory\": " << table.memory << ", \"load_factor\": " << table.load_factor
+        << ", \"mean_probe\": " << table.mean_probe << ", \"max_probe\": " << table.max_probe << "}";
+}
+
+} // namespace
+
+void solver_stats_t::write_json(std::ostream& out) const
+{
+    out << "{\"gates\": {";
+    for (size_t i = 0; i < cxxsat::NUM_GATE_KINDS; i++)
+    {
+        const cxxsat::gate_stats_t& gate = gates[i];
+        out << (i == 0 ? "" : ", ") << "\"" << to_string(static_cast<gate_kind_t>(i)) << "\": {"
+            << "\"lookups\": " << gate.lookups << ", \"hits\": " << gate.hits
+            << ", \"folds\": " << gate.folds << ", \"inserts\": " << gate.inserts
+            << ", \"clauses\": " << gate.clauses << ", \"vars\": " << gate.vars << "}";
+    }
+    out << "}, \"tables\": {";
+    write_table(out, "and", and_table);
+    out << ", ";
+    write_table(out, "xor", xor_table);
+    out << ", ";
+    write_table(out, "mux", mux_table);
+    out << ", ";
+    write_table(out, "xor3", xor3_table);
+    out << ", ";
+    write_table(out, "maj", maj_table);
+    out << ", ";
+    write_table(out, "and_n", and_n_table);
+    out << ", ";
+    write_table(out, "xor_n", xor_n_table);
+    out << "}}";
+}
@@ -0,0 +1,62 @@
+#ifndef CXXSAT_STATS_H
+#define CXXSAT_STATS_H
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <ostream>
+
+namespace cxxsat {
+
+/// Kinds of gates and constraint builders with separate statistics
+enum class gate_kind_t : uint32_t {
+    AND,   ///< Binary AND, including OR through De Morgan
+    XOR,   ///< Binary XOR
+    MUX,   ///< MUX(s, t, e)
+    XOR3,  ///< Ternary XOR
+    MAJ,   ///< Ternary majority
+    AND_N, ///< N-ary AND, including N-ary OR
+    XOR_N, ///< N-ary XOR
+    CARD,  ///< Cardinality constraints
+    PB     ///< Pseudo-Boolean constraints
+};
+constexpr size_t NUM_GATE_KINDS = 9;
+
+/// Returns the lower-case name of \a kind
+const char* to_string(gate_kind_t kind);
+
+/// Counters of a single gate kind. Builders count the clauses and variables of
+/// the gates they create through other builders as well
+struct gate_stats_t {
+    /// Cache lookups and the ones that found an existing gate
+    uint64_t lookups = 0, hits = 0;
+    /// Requests answered by constant folding or local rewriting, without a lookup
+    uint64_t folds = 0;
+    /// Newly registered gates
+    uint64_t inserts = 0;
+    /// Emitted clauses and allocated variables
+    uint64_t clauses = 0, vars = 0;
+};
+
+/// Occupancy of a single gate cache
+struct table_stats_t {
+    size_t size = 0, capacity = 0, memory = 0;
+    double load_factor = 0.0;
+    /// Average and maximum number of slots probed to find a stored entry
+    double mean_probe = 0.0;
+    uint32_t max_probe = 0;
+};
+
+/// Snapshot of all statistics of a solver
+struct solver_stats_t {
+    std::array<gate_stats_t, NUM_GATE_KINDS> gates;
+    table_stats_t and_table, xor_table, mux_table, xor3_table, maj_table, and_n_table, xor_n_table;
+
+    const gate_stats_t& operator[](gate_kind_t kind) const { return gates[static_cast<size_t>(kind)]; }
+    /// Writes all statistics as a single JSON object
+    void write_json(std::ostream& out) const;
+};
+
+} // namespace cxxsat
+
+#endif // CXXSAT_STATS_H
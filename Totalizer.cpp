@@ -0,0 +1,90 @@
+#include "Totalizer.h"
+#include <algorithm>
+
+using cxxsat::Totalizer;
+using cxxsat::var_t;
+
+Totalizer::Totalizer(Solver& solver, const std::vector<var_t>& ins) :
+        m_solver(solver), m_root(NO_NODE), m_num_ones(0)
+{
+    add_inputs(ins);
+}
+
+uint32_t Totalizer::size() const noexcept
+{
+    const uint32_t num_vars = (m_root == NO_NODE) ? 0 : m_nodes[m_root].size;
+    return num_vars + m_num_ones;
+}
+
+uint32_t Totalizer::merge(uint32_t left, uint32_t right)
+{
+    const uint32_t size = m_nodes[left].size + m_nodes[right].size;
+    m_nodes.push_back({left, right, size, {}});
+    return static_cast<uint32_t>(m_nodes.size() - 1);
+}
+
+uint32_t Totalizer::build(const std::vector<var_t>& ins)
+{
+    std::vector<uint32_t> level, next;
+    for (var_t in_var : ins)
+    {
+        Assert(is_legal(in_var), ILLEGAL_LITERAL);
+        Assert(m_solver.is_known(in_var), UNKNOWN_LITERAL);
+        if (in_var == var_t::ZERO) continue;
+        if (in_var == var_t::ONE) { m_num_ones += 1; continue; }
+        m_nodes.push_back({NO_NODE, NO_NODE, 1, {in_var}});
+        level.push_back(static_cast<uint32_t>(m_nodes.size() - 1));
+    }
+    if (level.empty()) return NO_NODE;
+
+    while (level.size() != 1)
+    {
+        next.clear();
+        for (size_t i = 0; i + 1 < level.size(); i += 2)
+            next.push_back(merge(level[i], level[i + 1]));
+        if (level.size() % 2 == 1) next.push_back(level.back());
+        level.swap(next);
+    }
+    return level[0];
+}
+
+void Totalizer::add_inputs(const std::vector<var_t>& ins)
+{
+    const uint32_t sub = build(ins);
+    if (sub == NO_NODE) return;
+    m_root = (m_root == NO_NODE) ? sub : merge(m_root, sub);
+}
+
+void Totalizer::extend(uint32_t node, uint32_t num)
+{
+    num = std::min(num, m_nodes[node].size);
+    if (m_nodes[node].outputs.size() >= num) return;
+
+    const uint32_t left = m_nodes[node].left, right = m_nodes[node].right;
+    extend(left, num);
+    extend(right, num);
+
+    // Outputs already encoded stay exact, since their clauses never mention the new child outputs
+    std::vector<var_t>& outputs = m_nodes[node].outputs;
+    const uint32_t from = static_cast<uint32_t>(outputs.size());
+    while (outputs.size() < num) outputs.push_back(m_solver.new_var());
+    m_solver.encode_unary_sum(m_nodes[left].outputs, m_nodes[right].outputs, outputs, from);
+}
+
+var_t Totalizer::at_most(uint32_t k)
+{
+    if (k >= size()) return var_t::ONE;
+    if (k < m_num_ones) return var_t::ZERO;
+    k -= m_num_ones;
+    const int nvars_start = m_solver.num_vars();
+    const int nclauses_start = m_solver.num_clauses();
+    extend(m_root, k + 1);
+    m_solver.count_emitted(gate_kind_t::CARD, nvars_start, nclauses_start);
+    return -m_nodes[m_root].outputs[k];
+}
+
+var_t Totalizer::at_least(uint32_t k)
+{
+    if (k == 0) return var_t::ONE;
+    return -at_most(k - 1);
+}
@@ -0,0 +1,57 @@
+#ifndef CXXSAT_TOTALIZER_H
+#define CXXSAT_TOTALIZER_H
+
+#include "Solver.h"
+#include <vector>
+
+namespace cxxsat {
+
+/// Incremental totalizer whose unary outputs are only encoded up to the largest requested bound.
+/// Tightening or relaxing the bound reuses all clauses emitted so far, and new inputs are merged
+/// into the existing tree instead of re-encoding it.
+class Totalizer {
+private:
+    static constexpr uint32_t NO_NODE = UINT32_MAX;
+
+    struct node_t {
+        /// Children of the node, or NO_NODE for leaves
+        uint32_t left, right;
+        /// Number of inputs below the node
+        uint32_t size;
+        /// outputs[i] is set iff at least i + 1 inputs below the node are set
+        std::vector<var_t> outputs;
+    };
+
+    /// Solver receiving the clauses of the totalizer
+    Solver& m_solver;
+    /// All nodes of the tree, children are always stored before their parents
+    std::vector<node_t> m_nodes;
+    /// Root of the tree, or NO_NODE if there are no non-constant inputs
+    uint32_t m_root;
+    /// Number of inputs that are constant ONE
+    uint32_t m_num_ones;
+
+    /// Builds a balanced tree over \a ins and returns its root
+    uint32_t build(const std::vector<var_t>& ins);
+    /// Creates a new inner node with the given children
+    uint32_t merge(uint32_t left, uint32_t right);
+    /// Makes sure the first \a num outputs of \a node are encoded
+    void extend(uint32_t node, uint32_t num);
+public:
+    /// Creates a totalizer over \a ins, no clauses are emitted before a bound is requested
+    Totalizer(Solver& solver, const std::vector<var_t>& ins);
+
+    /// Returns the number of inputs
+    uint32_t size() const noexcept;
+    /// Adds more inputs, outputs of already requested bounds are kept valid
+    void add_inputs(const std::vector<var_t>& ins);
+
+    /// Returns a variable representing SUM(ins) <= k
+    var_t at_most(uint32_t k);
+    /// Returns a variable representing SUM(ins) >= k
+    var_t at_least(uint32_t k);
+};
+
+} // namespace cxxsat
+
+#endif // CXXSAT_TOTALIZER_H
@@ -0,0 +1,291 @@
+#include "Trace.h"
+#include "Solver.h"
+#include <stdexcept>
+#include <fstream>
+#include <iterator>
+#include <chrono>
+
+using cxxsat::TraceWriter;
+using cxxsat::var_t;
+using cxxsat::trace_op_t;
+using cxxsat::trace_phase_t;
+
+namespace {
+
+/// Leading bytes of every trace, followed by the format version
+constexpr uint8_t TRACE_MAGIC[4] = {'C', 'X', 'T', 'R'};
+constexpr uint8_t TRACE_VERSION = 1;
+
+/// Codes of the constants, all other literals are shifted past them
+constexpr uint64_t CODE_ONE = 0;
+constexpr uint64_t CODE_ZERO = 1;
+
+inline uint64_t zigzag(int64_t value) { return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63); }
+inline int64_t unzigzag(uint64_t value) { return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1); }
+
+/// Sequential decoder of a trace held in memory
+class TraceReader {
+private:
+    const std::vector<uint8_t>& m_data;
+    size_t m_pos;
+public:
+    TraceReader(const std::vector<uint8_t>& data, size_t pos) : m_data(data), m_pos(pos) { }
+
+    bool at_end() const { return m_pos == m_data.size(); }
+    size_t pos() const { return m_pos; }
+
+    uint8_t read_byte()
+    {
+        if (m_pos == m_data.size()) throw std::runtime_error("Truncated trace");
+        return m_data[m_pos++];
+    }
+
+    uint64_t read_uint()
+    {
+        uint64_t value = 0;
+        for (uint32_t shift = 0; shift < 64; shift += 7)
+        {
+            const uint8_t byte = read_byte();
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) return value;
+        }
+        throw std::runtime_error("Malformed number in trace");
+    }
+
+    int64_t read_int() { return unzigzag(read_uint()); }
+
+    var_t read_lit(int32_t num_vars)
+    {
+        const uint64_t code = read_uint();
+        if (code == CODE_ONE) return var_t::ONE;
+        if (code == CODE_ZERO) return var_t::ZERO;
+        const int64_t var = num_vars - unzigzag((code - 2) >> 1);
+        if (var <= 0 || var >= INT32_MAX) throw std::runtime_error("Malformed literal in trace");
+        const var_t x = cxxsat::as_var(static_cast<int32_t>(var));
+        return ((code - 2) & 1) ? -x : x;
+    }
+
+    std::vector<var_t> read_lits(int32_t num_vars)
+    {
+        const uint64_t size = read_uint();
+        if (size > m_data.size() - m_pos) throw std::runtime_error("Malformed literal count in trace");
+        std::vector<var_t> lits;
+        lits.reserve(size);
+        for (uint64_t i = 0; i < size; i++) lits.push_back(read_lit(num_vars));
+        return lits;
+    }
+};
+
+} // namespace
+
+TraceWriter::TraceWriter(const std::string& path) : m_file(nullptr), m_failed(false), m_num_ops(0)
+{
+    m_file = std::fopen(path.c_str(), "wb");
+    if (m_file == nullptr) throw std::runtime_error("Cannot open " + path + " for writing");
+    m_buffer.reserve(BUFFER_SIZE + 64);
+    m_buffer.insert(m_buffer.end(), std::begin(TRACE_MAGIC), std::end(TRACE_MAGIC));
+    m_buffer.push_back(TRACE_VERSION);
+}
+
+TraceWriter::~TraceWriter()
+{
+    if (m_file == nullptr) return;
+    try { close(); } catch (const std::exception&) { }
+}
+
+void TraceWriter::drain() noexcept
+{
+    if (!m_failed && std::fwrite(m_buffer.data(), 1, m_buffer.size(), m_file) != m_buffer.size())
+        m_failed = true;
+    m_buffer.clear();
+}
+
+void TraceWriter::write_op(trace_op_t op)
+{
+    Assert(m_file != nullptr, TRACE_CLOSED);
+    // Operations are only split across drains if they are larger than the buffer
+    if (m_buffer.size() >= BUFFER_SIZE) drain();
+    m_buffer.push_back(static_cast<uint8_t>(op));
+    m_num_ops += 1;
+}
+
+void TraceWriter::write_uint(uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        m_buffer.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    m_buffer.push_back(static_cast<uint8_t>(value));
+}
+
+void TraceWriter::write_int(int64_t value)
+{
+    write_uint(zigzag(value));
+}
+
+void TraceWriter::write_lit(var_t x, int32_t num_vars)
+{
+    if (x == var_t::ONE) { write_uint(CODE_ONE); return; }
+    if (x == var_t::ZERO) { write_uint(CODE_ZERO); return; }
+    const int64_t delta = static_cast<int64_t>(num_vars) - as_int(abs_var_t(x));
+    write_uint(((zigzag(delta) << 1) | is_negated(x)) + 2);
+}
+
+void TraceWriter::write_lits(const var_t* lits, size_t size, int32_t num_vars)
+{
+    write_uint(size);
+    for (size_t i = 0; i < size; i++) write_lit(lits[i], num_vars);
+}
+
+void TraceWriter::close()
+{
+    Assert(m_file != nullptr, TRACE_CLOSED);
+    drain();
+    const bool failed = (std::fclose(m_file) != 0) || m_failed;
+    m_file = nullptr;
+    if (failed) throw std::runtime_error("Cannot write trace");
+}
+
+std::vector<trace_phase_t> cxxsat::replay_trace(Solver& solver, const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error("Cannot open " + path);
+    const std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (data.size() < 5 || !std::equal(std::begin(TRACE_MAGIC), std::end(TRACE_MAGIC), data.begin()))
+        throw std::runtime_error(path + " is not a cxxsat trace");
+    if (data[4] != TRACE_VERSION) throw std::runtime_error("Unsupported trace version in " + path);
+
+    using clock = std::chrono::steady_clock;
+    std::vector<trace_phase_t> phases;
+    trace_phase_t encode = {false, 0, 0.0, 0};
+    auto start = clock::now();
+    auto seconds_since = [](clock::time_point from) {
+        return std::chrono::duration<double>(clock::now() - from).count();
+    };
+
+    TraceReader reader(data, 5);
+    std::vector<int64_t> weights;
+    while (!reader.at_end())
+    {
+        const uint8_t op = reader.read_byte();
+        const int32_t nv = solver.num_vars();
+        switch (static_cast<trace_op_t>(op))
+        {
+        case trace_op_t::NEW_VARS:
+        {
+            const uint64_t num = reader.read_uint();
+            if (num > static_cast<uint64_t>(INT32_MAX - 1 - nv)) throw std::runtime_error("Malformed trace");
+            solver.new_vars(static_cast<int>(num));
+            break;
+        }
+        case trace_op_t::AND:
+        case trace_op_t::OR:
+        case trace_op_t::XOR:
+        {
+            const var_t a = reader.read_lit(nv), b = reader.read_lit(nv);
+            if (op == static_cast<uint8_t>(trace_op_t::AND)) solver.make_and(a, b);
+            else if (op == static_cast<uint8_t>(trace_op_t::OR)) solver.make_or(a, b);
+            else solver.make_xor(a, b);
+            break;
+        }
+        case trace_op_t::MUX:
+        case trace_op_t::XOR3:
+        case trace_op_t::MAJ:
+        {
+            const var_t a = reader.read_lit(nv), b = reader.read_lit(nv), c = reader.read_lit(nv);
+            if (op == static_cast<uint8_t>(trace_op_t::MUX)) solver.make_mux(a, b, c);
+            else if (op == static_cast<uint8_t>(trace_op_t::XOR3)) solver.make_xor3(a, b, c);
+            else solver.make_maj(a, b, c);
+            break;
+        }
+        case trace_op_t::AND_N: solver.make_and(reader.read_lits(nv)); break;
+        case trace_op_t::OR_N: solver.make_or(reader.read_lits(nv)); break;
+        case trace_op_t::XOR_N: solver.make_xor(reader.read_lits(nv)); break;
+        case trace_op_t::AT_MOST:
+        case trace_op_t::AT_LEAST:
+        {
+            const std::vector<var_t> ins = reader.read_lits(nv);
+            const uint32_t k = static_cast<uint32_t>(reader.read_int());
+            const auto encoding = static_cast<card_encoding_t>(reader.read_uint());
+            if (op == static_cast<uint8_t>(trace_op_t::AT_MOST)) solver.make_at_most(ins, k, encoding);
+            else solver.make_at_least(ins, k, encoding);
+            break;
+        }
+        case trace_op_t::PB_LE:
+        case trace_op_t::PB_GE:
+        case trace_op_t::PB_EQ:
+        {
+            const std::vector<var_t> ins = reader.read_lits(nv);
+            weights.clear();
+            for (size_t i = 0; i < ins.size(); i++) weights.push_back(reader.read_int());
+            const int64_t bound = reader.read_int();
+            const auto encoding = static_cast<pb_encoding_t>(reader.read_uint());
+            if (op == static_cast<uint8_t>(trace_op_t::PB_LE)) solver.make_pb_le(ins, weights, bound, encoding);
+            else if (op == static_cast<uint8_t>(trace_op_t::PB_GE)) solver.make_pb_ge(ins, weights, bound, encoding);
+            else solver.make_pb_eq(ins, weights, bound, encoding);
+            break;
+        }
+        case trace_op_t::CLAUSE: solver.add_clause(reader.read_lits(nv)); break;
+        case trace_op_t::ASSUME: solver.assume(reader.read_lit(nv)); break;
+        case trace_op_t::EQUIVALENCE:
+        {
+            const var_t a = reader.read_lit(nv), b = reader.read_lit(nv);
+            solver.add_equivalence(a, b);
+            break;
+        }
+        case trace_op_t::XOR_CONSTRAINT:
+        {
+            const std::vector<var_t> lits = reader.read_lits(nv);
+            solver.add_xor(lits, reader.read_uint() != 0);
+            break;
+        }
+        case trace_op_t::AT_MOST_ONE:
+        case trace_op_t::EXACTLY_ONE:
+        {
+            const std::vector<var_t> ins = reader.read_lits(nv);
+            const auto encoding = static_cast<amo_encoding_t>(reader.read_uint());
+            if (op == static_cast<uint8_t>(trace_op_t::AT_MOST_ONE)) solver.make_at_most_one(ins, encoding);
+            else solver.make_exactly_one(ins, encoding);
+            break;
+        }
+        case trace_op_t::ADD_AT_MOST_ONE:
+        case trace_op_t::ADD_EXACTLY_ONE:
+        {
+            const std::vector<var_t> ins = reader.read_lits(nv);
+            const auto encoding = static_cast<amo_encoding_t>(reader.read_uint());
+            const var_t act = reader.read_lit(nv);
+            if (op == static_cast<uint8_t>(trace_op_t::ADD_AT_MOST_ONE)) solver.add_at_most_one(ins, encoding, act);
+            else solver.add_exactly_one(ins, encoding, act);
+            break;
+        }
+        case trace_op_t::CHECK:
+        case trace_op_t::CHECK_TIMED:
+        {
+            const bool timed = (op == static_cast<uint8_t>(trace_op_t::CHECK_TIMED));
+            const double limit = timed ? static_cast<double>(reader.read_uint()) * 1e-6 : 0.0;
+            encode.seconds = seconds_since(start);
+            if (encode.num_ops != 0) phases.push_back(encode);
+            start = clock::now();
+            const int state = timed ? solver.check_timed(limit) : solver.check();
+            phases.push_back({true, 1, seconds_since(start), state});
+            encode = {false, 0, 0.0, 0};
+            start = clock::now();
+            continue;
+        }
+        default:
+            throw std::runtime_error("Unknown operation in trace at byte " + std::to_string(reader.pos() - 1));
+        }
+        encode.num_ops += 1;
+    }
+    encode.seconds = seconds_since(start);
+    if (encode.num_ops != 0)
+    {
+        // Include the time to pass the last clauses to the backend
+        start = clock::now();
+        solver.flush();
+        encode.seconds += seconds_since(start);
+        phases.push_back(encode);
+    }
+    return phases;
+}
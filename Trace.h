@@ -0,0 +1,106 @@
+#ifndef CXXSAT_TRACE_H
+#define CXXSAT_TRACE_H
+
+#include "vars.h"
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace cxxsat {
+
+class Solver;
+
+constexpr const char* TRACE_CLOSED = "Trace writer is already closed";
+
+/// Operations of a formula trace. Each operation is a single byte followed by its
+/// arguments, counts and other numbers are LEB128 varints and signed numbers are
+/// zigzag-encoded. Literals are varints relative to the number of variables at the
+/// time of the call, so literals of recently created variables take a single byte
+enum class trace_op_t : uint8_t {
+    NEW_VARS = 1, ///< count
+    AND,          ///< a, b
+    OR,           ///< a, b
+    XOR,          ///< a, b
+    MUX,          ///< s, t, e
+    XOR3,         ///< a, b, c
+    MAJ,          ///< a, b, c
+    AND_N,        ///< count, literals
+    OR_N,         ///< count, literals
+    XOR_N,        ///< count, literals
+    AT_MOST,      ///< count, literals, signed k, encoding
+    AT_LEAST,     ///< count, literals, signed k, encoding
+    PB_LE,        ///< count, literals, signed weights, signed bound, encoding
+    PB_GE,        ///< count, literals, signed weights, signed bound, encoding
+    PB_EQ,        ///< count, literals, signed weights, signed bound, encoding
+    CLAUSE,       ///< count, literals
+    ASSUME,       ///< literal
+    CHECK,        ///< no arguments
+    CHECK_TIMED,  ///< time limit in microseconds
+    EQUIVALENCE,  ///< a, b
+    XOR_CONSTRAINT, ///< count, literals, rhs
+    AT_MOST_ONE,    ///< count, literals, encoding
+    EXACTLY_ONE,    ///< count, literals, encoding
+    ADD_AT_MOST_ONE, ///< count, literals, encoding, activation literal
+    ADD_EXACTLY_ONE  ///< count, literals, encoding, activation literal
+};
+
+/// Buffered writer of a binary formula trace. Write errors do not interrupt the traced
+/// solver, they are reported by close
+class TraceWriter {
+private:
+    /// Number of buffered bytes after which the buffer is written out
+    static constexpr size_t BUFFER_SIZE = 1 << 16;
+
+    std::FILE* m_file;
+    std::vector<uint8_t> m_buffer;
+    bool m_failed;
+    uint64_t m_num_ops;
+
+    /// Writes the buffer to the file, remembering failures
+    void drain() noexcept;
+public:
+    /// Creates \a path and writes the trace header, throws std::runtime_error on I/O errors
+    explicit TraceWriter(const std::string& path);
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+    /// Closes the writer if that has not happened yet, ignoring errors
+    ~TraceWriter();
+
+    /// Starts a new operation
+    void write_op(trace_op_t op);
+    /// Appends an unsigned or a signed number
+    void write_uint(uint64_t value);
+    void write_int(int64_t value);
+    /// Appends a literal relative to \a num_vars variables
+    void write_lit(var_t x, int32_t num_vars);
+    /// Appends the number of literals followed by the literals
+    void write_lits(const var_t* lits, size_t size, int32_t num_vars);
+    /// Writes all buffered operations, throws std::runtime_error if any write failed
+    void close();
+
+    /// Returns the number of written operations
+    inline uint64_t num_ops() const noexcept { return m_num_ops; }
+    /// Returns true until the writer is closed
+    inline bool is_open() const noexcept { return m_file != nullptr; }
+};
+
+/// Timing of a maximal run of encoding operations or of a single check
+struct trace_phase_t {
+    /// True for a check, false for a run of encoding operations
+    bool solve;
+    /// Number of replayed operations
+    uint64_t num_ops;
+    /// Wall time of the phase
+    double seconds;
+    /// Result of the check, or 0 for encoding phases
+    int state;
+};
+
+/// Re-executes the trace \a path on \a solver and returns the phases in order.
+/// Throws std::runtime_error on I/O errors and malformed traces
+std::vector<trace_phase_t> replay_trace(Solver& solver, const std::string& path);
+
+} // namespace cxxsat
+
+#endif // CXXSAT_TRACE_H
@@ -1,10 +1,89 @@
 #include <cassert>
+#include <utility>
+#include <algorithm>
 #include "VarManager.h"
 
 using cxxsat::VarManager;
 using cxxsat::var_t;
 
-VarManager::VarManager() : m_num_vars(0), hits(0) { }
+VarManager::VarManager() : m_num_vars(0), m_stats(), m_num_substituted(0), hits(0) { }
+
+cxxsat::solver_stats_t VarManager::stats() const
+{
+    solver_stats_t res;
+    res.gates = m_stats;
+    res.and_table = m_and_cache.stats();
+    res.xor_table = m_xor_cache.stats();
+    res.mux_table = m_mux_cache.stats();
+    res.xor3_table = m_xor3_cache.stats();
+    res.maj_table = m_maj_cache.stats();
+    res.and_n_table = m_and_n_cache.stats();
+    res.xor_n_table = m_xor_n_cache.stats();
+    return res;
+}
+
+///////////////////////////////// SUBSTITUTION /////////////////////////////////
+
+var_t VarManager::find_representative(var_t x)
+{
+    const size_t var = static_cast<size_t>(as_int(abs_var_t(x)));
+    // r is the current literal equivalent to the positive variable
+    var_t r = m_repr[var];
+    while (!is_const(r))
+    {
+        const size_t next = static_cast<size_t>(as_int(abs_var_t(r)));
+        if (next >= m_repr.size() || m_repr[next] == var_t::ILLEGAL) break;
+        r = is_negated(r) ? -m_repr[next] : m_repr[next];
+    }
+    m_repr[var] = r;
+    return is_negated(x) ? -r : r;
+}
+
+void VarManager::assert_unit(var_t x)
+{
+    assert_equivalent(x, var_t::ONE);
+}
+
+void VarManager::assert_equivalent(var_t a, var_t b)
+{
+    Assert(is_legal(a), ILLEGAL_LITERAL);
+    Assert(is_legal(b), ILLEGAL_LITERAL);
+    Assert(is_known(a), UNKNOWN_LITERAL);
+    Assert(is_known(b), UNKNOWN_LITERAL);
+
+    a = substitute(a), b = substitute(b);
+    // Already known, or a contradiction left to the backend
+    if (a == b || a == -b) return;
+    // Constants and older variables become representatives
+    if (is_const(b) || (!is_const(a) && abs_var_t(b) < abs_var_t(a))) std::swap(a, b);
+    if (is_negated(b)) { a = -a, b = -b; }
+
+    const int32_t var = as_int(b);
+    if (m_repr.size() <= static_cast<size_t>(var)) m_repr.resize(static_cast<size_t>(num_vars()) + 1, var_t::ILLEGAL);
+    m_repr[var] = a;
+    m_num_substituted += 1;
+
+    const auto it = m_xor_defs.find(var);
+    if (it == m_xor_defs.end()) return;
+    const xor_def_t def = it->second;
+    m_xor_defs.erase(it);
+    // Move the definition to the representative of the output
+    define_xor(def.a, def.b, def.parity ? -b : b);
+}
+
+void VarManager::define_xor(var_t a, var_t b, var_t c)
+{
+    const bool neg = is_negated(a) ^ is_negated(b) ^ is_negated(c);
+    a = abs_var_t(a), b = abs_var_t(b);
+    const var_t r = substitute(abs_var_t(c));
+    if (is_const(r))
+    {
+        // The XOR inputs are equal or complementary
+        const bool parity = neg ^ (r == var_t::ONE);
+        assert_equivalent(a, parity ? -b : b);
+    }
+    else m_xor_defs.emplace(as_int(abs_var_t(r)), xor_def_t{a, b, neg != is_negated(r)});
+}
 
 ///////////////////////////////// AND /////////////////////////////////
 
@@ -16,9 +95,15 @@ var_t VarManager::lookup_and(var_t a, var_t b)
     Assert(is_known(b), UNKNOWN_LITERAL);
 
     const binary_key_t key = {a < b ? a : b, a < b ? b : a};
+    gate_stats_t& stats = stats_of(gate_kind_t::AND);
+    stats.lookups += 1;
     auto res = m_and_cache.find(key);
-    if (res != m_and_cache.end()) return res->second;
-    else                          return var_t::ILLEGAL;
+    if (res != m_and_cache.end())
+    {
+        stats.hits += 1;
+        return res->second;
+    }
+    else return var_t::ILLEGAL;
 }
 
 var_t VarManager::simplify_and(var_t a, var_t b)
@@ -39,9 +124,12 @@ var_t VarManager::simplify_and(var_t a, var_t b)
 
     // See if we already have a variable for this
     res = lookup_and(a, b);
-done:
     if (res != var_t::ILLEGAL) { hits += 1; }
     return res;
+done:
+    stats_of(gate_kind_t::AND).folds += 1;
+    hits += 1;
+    return res;
 }
 
 void VarManager::register_and(var_t a, var_t b, var_t c)
@@ -55,6 +143,7 @@ void VarManager::register_and(var_t a, var_t b, var_t c)
     Assert(is_known(c), UNKNOWN_LITERAL);
 
     const binary_key_t key = {a < b ? a : b, a < b ? b : a};
+    stats_of(gate_kind_t::AND).inserts += 1;
     m_and_cache.emplace(key, c);
 }
 
@@ -87,9 +176,12 @@ var_t VarManager::lookup_xor(var_t a, var_t b)
     bool neg = is_negated(a) ^ is_negated(b);
     a = abs_var_t(a), b = abs_var_t(b);
     const binary_key_t key = {a < b ? a : b, a < b ? b : a};
+    gate_stats_t& stats = stats_of(gate_kind_t::XOR);
+    stats.lookups += 1;
     auto res = m_xor_cache.find(key);
     if (res != m_xor_cache.end())
     {
+        stats.hits += 1;
         const var_t c = res->second;
         return neg ? -c : +c;
     }
@@ -113,9 +205,12 @@ var_t VarManager::simplify_xor(var_t a, var_t b)
     if (a == -b) { res = var_t::ONE; goto done; }
 
     res = lookup_xor(a, b);
-done:
     if (res != var_t::ILLEGAL) { hits += 1; }
     return res;
+done:
+    stats_of(gate_kind_t::XOR).folds += 1;
+    hits += 1;
+    return res;
 }
 
 void VarManager::register_xor(var_t a, var_t b, var_t c)
@@ -130,6 +225,7 @@ void VarManager::register_xor(var_t a, var_t b, var_t c)
 
     bool neg = is_negated(a) ^ is_negated(b) ^ is_negated(c);
     a = abs_var_t(a), b = abs_var_t(b), c = abs_var_t(c);
+    stats_of(gate_kind_t::XOR).inserts += 1;
 
     {
         const binary_key_t key = {a < b ? a : b,
@@ -178,9 +274,12 @@ var_t VarManager::lookup_mux(var_t s, var_t t, var_t e)
     if (neg) { t = -t, e = -e; }
 
     const ternary_key_t key = {s, t, e};
+    gate_stats_t& stats = stats_of(gate_kind_t::MUX);
+    stats.lookups += 1;
     auto res = m_mux_cache.find(key);
     if (res != m_mux_cache.end())
     {
+        stats.hits += 1;
         var_t r = res->second;
         return neg ? -r : +r;
     }
@@ -196,27 +295,32 @@ var_t VarManager::simplify_mux(var_t s, var_t t, var_t e)
     Assert(is_known(t), UNKNOWN_LITERAL);
     Assert(is_known(e), UNKNOWN_LITERAL);
 
+    var_t res = var_t::ILLEGAL;
+
     // The formula representation is (s & t) | (-s & e)
-    if (s == var_t::ONE) return t;  // ... = t | 0 = t
-    if (s == var_t::ZERO) return e; // ... = 0 | e = e
+    if (s == var_t::ONE)  { res = t; goto done; } // ... = t | 0 = t
+    if (s == var_t::ZERO) { res = e; goto done; } // ... = 0 | e = e
 
-    if (t == e) return t;           // ... = t & (-s | s) = t
+    if (t == e) { res = t; goto done; }           // ... = t & (-s | s) = t
 
-    if (t == var_t::ONE) return make_or(s, e);    // ... = s | (-s & e) = s | e
-    if (t == var_t::ZERO) return make_and(-s, e); // ... = 0 | (-s & e) = (-s & e)
+    if (t == var_t::ONE)  { res = make_or(s, e); goto done; }   // ... = s | (-s & e) = s | e
+    if (t == var_t::ZERO) { res = make_and(-s, e); goto done; } // ... = 0 | (-s & e) = (-s & e)
 
-    if (e == var_t::ONE) return make_or(-s, t);   // ... = (s & t) | -s  = -s | t
-    if (e == var_t::ZERO) return make_and(s, t);  // ... = (s & t) | 0 = (s & t)
+    if (e == var_t::ONE)  { res = make_or(-s, t); goto done; }  // ... = (s & t) | -s  = -s | t
+    if (e == var_t::ZERO) { res = make_and(s, t); goto done; }  // ... = (s & t) | 0 = (s & t)
 
-    if (t == -e) return make_xor(s, e);  // ... = (s & -e) | (-s & e)
+    if (t == -e) { res = make_xor(s, e); goto done; }  // ... = (s & -e) | (-s & e)
 
-    if (t == s) return make_or(s, e);    // ... = s | (-s & e) = s | e
-    if (t == -s) return make_and(-s, e); // ... = 0 | (-s & e) = (-s & e);
+    if (t == s)  { res = make_or(s, e); goto done; }   // ... = s | (-s & e) = s | e
+    if (t == -s) { res = make_and(-s, e); goto done; } // ... = 0 | (-s & e) = (-s & e);
 
-    if (e == s) return make_and(s, t);   // ... = (s & t) | 0  = (s & t)
-    if (e == -s) return make_or(-s, t);  // ... = (s & t) | -s = -s | t
+    if (e == s)  { res = make_and(s, t); goto done; }  // ... = (s & t) | 0  = (s & t)
+    if (e == -s) { res = make_or(-s, t); goto done; }  // ... = (s & t) | -s = -s | t
 
     return lookup_mux(s, t, e);
+done:
+    stats_of(gate_kind_t::MUX).folds += 1;
+    return res;
 }
 
 void VarManager::register_mux(var_t s, var_t t, var_t e, var_t r)
@@ -245,5 +349,295 @@ void VarManager::register_mux(var_t s, var_t t, var_t e, var_t r)
     if (neg) { t = -t, e = -e, r = -r; }
 
     const ternary_key_t key = {s, t, e};
+    stats_of(gate_kind_t::MUX).inserts += 1;
     m_mux_cache.emplace(key, r);
 }
+
+///////////////////////////////// XOR3 /////////////////////////////////
+
+namespace {
+
+/// Sorts three literals by their variables in ascending order
+inline void sort3(var_t& a, var_t& b, var_t& c)
+{
+    using cxxsat::abs_var_t;
+    if (abs_var_t(b) < abs_var_t(a)) std::swap(a, b);
+    if (abs_var_t(c) < abs_var_t(b)) std::swap(b, c);
+    if (abs_var_t(b) < abs_var_t(a)) std::swap(a, b);
+}
+
+} // namespace
+
+var_t VarManager::lookup_xor3(var_t a, var_t b, var_t c)
+{
+    Assert(is_legal(a), ILLEGAL_LITERAL);
+    Assert(is_legal(b), ILLEGAL_LITERAL);
+    Assert(is_legal(c), ILLEGAL_LITERAL);
+    Assert(is_known(a), UNKNOWN_LITERAL);
+    Assert(is_known(b), UNKNOWN_LITERAL);
+    Assert(is_known(c), UNKNOWN_LITERAL);
+
+    bool neg = is_negated(a) ^ is_negated(b) ^ is_negated(c);
+    a = abs_var_t(a), b = abs_var_t(b), c = abs_var_t(c);
+    sort3(a, b, c);
+
+    const ternary_key_t key = {a, b, c};
+    gate_stats_t& stats = stats_of(gate_kind_t::XOR3);
+    stats.lookups += 1;
+    auto res = m_xor3_cache.find(key);
+    if (res != m_xor3_cache.end())
+    {
+        stats.hits += 1;
+        const var_t r = res->second;
+        return neg ? -r : +r;
+    }
+    else return var_t::ILLEGAL;
+}
+
+var_t VarManager::simplify_xor3(var_t a, var_t b, var_t c)
+{
+    Assert(is_legal(a), ILLEGAL_LITERAL);
+    Assert(is_legal(b), ILLEGAL_LITERAL);
+    Assert(is_legal(c), ILLEGAL_LITERAL);
+    Assert(is_known(a), UNKNOWN_LITERAL);
+    Assert(is_known(b), UNKNOWN_LITERAL);
+    Assert(is_known(c), UNKNOWN_LITERAL);
+
+    var_t res = var_t::ILLEGAL;
+
+    // Constants and repeated variables reduce to a binary XOR
+    if (is_const(a)) { res = (a == var_t::ONE) ? -make_xor(b, c) : make_xor(b, c); goto done; }
+    if (is_const(b)) { res = (b == var_t::ONE) ? -make_xor(a, c) : make_xor(a, c); goto done; }
+    if (is_const(c)) { res = (c == var_t::ONE) ? -make_xor(a, b) : make_xor(a, b); goto done; }
+
+    if (a == b)  { res = c; goto done; }
+    if (a == -b) { res = -c; goto done; }
+    if (a == c)  { res = b; goto done; }
+    if (a == -c) { res = -b; goto done; }
+    if (b == c)  { res = a; goto done; }
+    if (b == -c) { res = -a; goto done; }
+
+    return lookup_xor3(a, b, c);
+done:
+    stats_of(gate_kind_t::XOR3).folds += 1;
+    return res;
+}
+
+void VarManager::register_xor3(var_t a, var_t b, var_t c, var_t r)
+{
+    Assert(is_legal(a), ILLEGAL_LITERAL);
+    Assert(is_legal(b), ILLEGAL_LITERAL);
+    Assert(is_legal(c), ILLEGAL_LITERAL);
+    Assert(is_legal(r), ILLEGAL_LITERAL);
+
+    Assert(is_known(a), UNKNOWN_LITERAL);
+    Assert(is_known(b), UNKNOWN_LITERAL);
+    Assert(is_known(c), UNKNOWN_LITERAL);
+    Assert(is_known(r), UNKNOWN_LITERAL);
+
+    bool neg = is_negated(a) ^ is_negated(b) ^ is_negated(c);
+    a = abs_var_t(a), b = abs_var_t(b), c = abs_var_t(c);
+    sort3(a, b, c);
+
+    const ternary_key_t key = {a, b, c};
+    stats_of(gate_kind_t::XOR3).inserts += 1;
+    m_xor3_cache.emplace(key, neg ? -r : +r);
+}
+
+///////////////////////////////// MAJ /////////////////////////////////
+
+var_t VarManager::lookup_maj(var_t a, var_t b, var_t c)
+{
+    Assert(is_legal(a), ILLEGAL_LITERAL);
+    Assert(is_legal(b), ILLEGAL_LITERAL);
+    Assert(is_legal(c), ILLEGAL_LITERAL);
+    Assert(is_known(a), UNKNOWN_LITERAL);
+    Assert(is_known(b), UNKNOWN_LITERAL);
+    Assert(is_known(c), UNKNOWN_LITERAL);
+
+    // MAJ is self-dual, so normalize the first input to be non-negated
+    sort3(a, b, c);
+    bool neg = is_negated(a);
+    if (neg) { a = -a, b = -b, c = -c; }
+
+    const ternary_key_t key = {a, b, c};
+    gate_stats_t& stats = stats_of(gate_kind_t::MAJ);
+    stats.lookups += 1;
+    auto res = m_maj_cache.find(key);
+    if (res != m_maj_cache.end())
+    {
+        stats.hits += 1;
+        const var_t r = res->second;
+        return neg ? -r : +r;
+    }
+    else return var_t::ILLEGAL;
+}
+
+var_t VarManager::simplify_maj(var_t a, var_t b, var_t c)
+{
+    Assert(is_legal(a), ILLEGAL_LITERAL);
+    Assert(is_legal(b), ILLEGAL_LITERAL);
+    Assert(is_legal(c), ILLEGAL_LITERAL);
+    Assert(is_known(a), UNKNOWN_LITERAL);
+    Assert(is_known(b), UNKNOWN_LITERAL);
+    Assert(is_known(c), UNKNOWN_LITERAL);
+
+    var_t res = var_t::ILLEGAL;
+
+    // A constant input turns MAJ into AND or OR of the others
+    if (a == var_t::ONE)  { res = make_or(b, c); goto done; }
+    if (a == var_t::ZERO) { res = make_and(b, c); goto done; }
+    if (b == var_t::ONE)  { res = make_or(a, c); goto done; }
+    if (b == var_t::ZERO) { res = make_and(a, c); goto done; }
+    if (c == var_t::ONE)  { res = make_or(a, b); goto done; }
+    if (c == var_t::ZERO) { res = make_and(a, b); goto done; }
+
+    // Two equal inputs decide, two complementary inputs leave the third
+    if (a == b)  { res = a; goto done; }
+    if (a == -b) { res = c; goto done; }
+    if (a == c)  { res = a; goto done; }
+    if (a == -c) { res = b; goto done; }
+    if (b == c)  { res = b; goto done; }
+    if (b == -c) { res = a; goto done; }
+
+    return lookup_maj(a, b, c);
+done:
+    stats_of(gate_kind_t::MAJ).folds += 1;
+    return res;
+}
+
+void VarManager::register_maj(var_t a, var_t b, var_t c, var_t r)
+{
+    Assert(is_legal(a), ILLEGAL_LITERAL);
+    Assert(is_legal(b), ILLEGAL_LITERAL);
+    Assert(is_legal(c), ILLEGAL_LITERAL);
+    Assert(is_legal(r), ILLEGAL_LITERAL);
+
+    Assert(is_known(a), UNKNOWN_LITERAL);
+    Assert(is_known(b), UNKNOWN_LITERAL);
+    Assert(is_known(c), UNKNOWN_LITERAL);
+    Assert(is_known(r), UNKNOWN_LITERAL);
+
+    sort3(a, b, c);
+    if (is_negated(a)) { a = -a, b = -b, c = -c, r = -r; }
+
+    const ternary_key_t key = {a, b, c};
+    stats_of(gate_kind_t::MAJ).inserts += 1;
+    m_maj_cache.emplace(key, r);
+}
+
+///////////////////////////////// N-ARY AND /////////////////////////////////
+
+var_t VarManager::lookup_and_n(const std::vector<var_t>& ins)
+{
+    gate_stats_t& stats = stats_of(gate_kind_t::AND_N);
+    stats.lookups += 1;
+    auto res = m_and_n_cache.find(ins);
+    if (res != m_and_n_cache.end())
+    {
+        stats.hits += 1;
+        return res->second;
+    }
+    else return var_t::ILLEGAL;
+}
+
+var_t VarManager::simplify_and_n(std::vector<var_t>& ins)
+{
+    var_t res = var_t::ILLEGAL;
+    size_t num = 0;
+    for (const var_t in_var : ins)
+    {
+        Assert(is_legal(in_var), ILLEGAL_LITERAL);
+        Assert(is_known(in_var), UNKNOWN_LITERAL);
+        if (in_var == var_t::ZERO) { res = var_t::ZERO; goto done; }
+        if (in_var != var_t::ONE) ins[num++] = in_var;
+    }
+    ins.resize(num);
+
+    // Sorting by variable places complementary inputs next to each other
+    std::sort(ins.begin(), ins.end(), [](var_t a, var_t b) {
+        return abs_var_t(a) < abs_var_t(b) || (abs_var_t(a) == abs_var_t(b) && a < b);
+    });
+    ins.erase(std::unique(ins.begin(), ins.end()), ins.end());
+    for (size_t i = 1; i < ins.size(); i++)
+        if (ins[i - 1] == -ins[i]) { res = var_t::ZERO; goto done; }
+
+    if (ins.empty())     { res = var_t::ONE; goto done; }
+    if (ins.size() == 1) { res = ins[0]; goto done; }
+    if (ins.size() == 2) return var_t::ILLEGAL;
+
+    return lookup_and_n(ins);
+done:
+    stats_of(gate_kind_t::AND_N).folds += 1;
+    return res;
+}
+
+void VarManager::register_and_n(const std::vector<var_t>& ins, var_t r)
+{
+    Assert(is_legal(r), ILLEGAL_LITERAL);
+    Assert(is_known(r), UNKNOWN_LITERAL);
+
+    stats_of(gate_kind_t::AND_N).inserts += 1;
+    m_and_n_cache.emplace(ins, r);
+}
+
+///////////////////////////////// N-ARY XOR /////////////////////////////////
+
+var_t VarManager::lookup_xor_n(const std::vector<var_t>& ins)
+{
+    gate_stats_t& stats = stats_of(gate_kind_t::XOR_N);
+    stats.lookups += 1;
+    auto res = m_xor_n_cache.find(ins);
+    if (res != m_xor_n_cache.end())
+    {
+        stats.hits += 1;
+        return res->second;
+    }
+    else return var_t::ILLEGAL;
+}
+
+var_t VarManager::simplify_xor_n(std::vector<var_t>& ins, bool& neg)
+{
+    var_t res = var_t::ILLEGAL;
+    neg = false;
+    size_t num = 0;
+    for (const var_t in_var : ins)
+    {
+        Assert(is_legal(in_var), ILLEGAL_LITERAL);
+        Assert(is_known(in_var), UNKNOWN_LITERAL);
+        if (is_const(in_var)) { neg ^= (in_var == var_t::ONE); continue; }
+        neg ^= is_negated(in_var);
+        ins[num++] = abs_var_t(in_var);
+    }
+    ins.resize(num);
+
+    // Equal variables cancel in pairs
+    std::sort(ins.begin(), ins.end());
+    num = 0;
+    for (size_t i = 0; i < ins.size(); i++)
+    {
+        if (i + 1 < ins.size() && ins[i] == ins[i + 1]) { i += 1; continue; }
+        ins[num++] = ins[i];
+    }
+    ins.resize(num);
+
+    if (ins.empty())     { res = var_t::ZERO; goto done; }
+    if (ins.size() == 1) { res = ins[0]; goto done; }
+    if (ins.size() == 2) return var_t::ILLEGAL;
+
+    res = lookup_xor_n(ins);
+    if (res == var_t::ILLEGAL) return res;
+    return neg ? -res : +res;
+done:
+    stats_of(gate_kind_t::XOR_N).folds += 1;
+    return neg ? -res : +res;
+}
+
+void VarManager::register_xor_n(const std::vector<var_t>& ins, var_t r)
+{
+    Assert(is_legal(r), ILLEGAL_LITERAL);
+    Assert(is_known(r), UNKNOWN_LITERAL);
+
+    stats_of(gate_kind_t::XOR_N).inserts += 1;
+    m_xor_n_cache.emplace(ins, r);
+}
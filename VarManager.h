@@ -4,6 +4,10 @@
 #include "debug.h"
 #include "vars.h"
 #include "keys.h"
+#include "GateTable.h"
+#include "Stats.h"
+#include <string>
+#include <vector>
 #include <unordered_map>
 
 namespace cxxsat {
@@ -11,15 +15,43 @@ namespace cxxsat {
 constexpr const char* ILLEGAL_LITERAL = "Found illegal literal when adding clause";
 constexpr const char* UNKNOWN_LITERAL = "Found unknown literal when adding clause";
 
+struct aiger_info_t;
+class VarManager;
+aiger_info_t write_aiger(const VarManager& manager, const std::string& path, const std::vector<var_t>& outputs);
+
 class VarManager {
+    friend aiger_info_t write_aiger(const VarManager& manager, const std::string& path,
+                                    const std::vector<var_t>& outputs);
 private:
     /// The number of currently allocated solver variables
     int32_t m_num_vars;
 protected:
     /// Cache for AND gates
-    std::unordered_map<binary_key_t , var_t> m_and_cache;
-    std::unordered_map<binary_key_t , var_t> m_xor_cache;
-    std::unordered_map<ternary_key_t , var_t> m_mux_cache;
+    GateTable<binary_key_t> m_and_cache;
+    GateTable<binary_key_t> m_xor_cache;
+    GateTable<ternary_key_t> m_mux_cache;
+    GateTable<ternary_key_t> m_xor3_cache;
+    GateTable<ternary_key_t> m_maj_cache;
+    /// Caches for n-ary AND and XOR gates over canonical input lists
+    GateTable<nary_key_t> m_and_n_cache;
+    GateTable<nary_key_t> m_xor_n_cache;
+    /// Counters of each gate kind
+    std::array<gate_stats_t, NUM_GATE_KINDS> m_stats;
+    /// Representative literal or constant of every substituted variable, ILLEGAL for
+    /// variables that represent themselves
+    std::vector<var_t> m_repr;
+    /// XOR definitions of gate outputs, a ^ b ^ output == parity over the variables,
+    /// which turn units on the output into equivalences of the inputs
+    struct xor_def_t { var_t a, b; bool parity; };
+    std::unordered_map<int32_t, xor_def_t> m_xor_defs;
+    /// Number of variables with a representative
+    uint32_t m_num_substituted;
+
+    /// Follows the representatives of the substituted literal \a x and shortens the path
+    var_t find_representative(var_t x);
+
+    /// Returns the counters of \a kind
+    inline gate_stats_t& stats_of(gate_kind_t kind) noexcept { return m_stats[static_cast<size_t>(kind)]; }
 
     /// Helper functions for the AND(a, b)
     var_t simplify_and(var_t a, var_t b);
@@ -35,14 +67,60 @@ protected:
     var_t simplify_xor(var_t a, var_t b);
     var_t lookup_xor(var_t a, var_t b);
     void register_xor(var_t a, var_t b, var_t c);
+    /// Records c == XOR(a, b) for deriving equivalences of the inputs from units on c. Only
+    /// valid once the clauses of the gate reached the backend, which the derived equivalences
+    /// would otherwise substitute away
+    void define_xor(var_t a, var_t b, var_t c);
 
     /// Helper functions for the MUX(s, t, e)
     var_t simplify_mux(var_t s, var_t t, var_t e);
     var_t lookup_mux(var_t s, var_t t, var_t e);
     void register_mux(var_t s, var_t t, var_t e, var_t r);
 
+    /// Helper functions for the XOR3(a, b, c)
+    var_t simplify_xor3(var_t a, var_t b, var_t c);
+    var_t lookup_xor3(var_t a, var_t b, var_t c);
+    void register_xor3(var_t a, var_t b, var_t c, var_t r);
+
+    /// Helper functions for the MAJ(a, b, c)
+    var_t simplify_maj(var_t a, var_t b, var_t c);
+    var_t lookup_maj(var_t a, var_t b, var_t c);
+    void register_maj(var_t a, var_t b, var_t c, var_t r);
+
+    /// Helper functions for the n-ary AND(ins). Simplification sorts \a ins, removes duplicates and
+    /// constant ONE inputs and detects complementary inputs, the other helpers expect this canonical form.
+    /// Canonical lists of two inputs are left to the binary AND without a lookup
+    var_t simplify_and_n(std::vector<var_t>& ins);
+    var_t lookup_and_n(const std::vector<var_t>& ins);
+    void register_and_n(const std::vector<var_t>& ins, var_t r);
+
+    /// Helper functions for the n-ary XOR(ins). Simplification replaces \a ins by its sorted
+    /// variables with cancelling pairs and constants removed, and sets \a neg to the parity of the
+    /// removed negations. The cache stores the XOR of the canonical variables without \a neg.
+    /// Canonical lists of two inputs are left to the binary XOR without a lookup
+    var_t simplify_xor_n(std::vector<var_t>& ins, bool& neg);
+    var_t lookup_xor_n(const std::vector<var_t>& ins);
+    void register_xor_n(const std::vector<var_t>& ins, var_t r);
+
 public:
+    /// Number of gate requests answered without a new gate, by folding or by the cache
     uint32_t hits;
+    /// Returns a snapshot of the gate counters and cache occupancy
+    solver_stats_t stats() const;
+    /// Recognizes AND, XOR and MUX definitions among the \a size literals of 0-terminated clauses
+    /// and registers them in the gate caches, so later requests for the same gates reuse the
+    /// defined variables. Each variable is taken as the output of at most one gate. Returns the
+    /// number of registered gates
+    size_t detect_gates(const int32_t* lits, size_t size);
+    /// Returns the representative of \a x, which is a constant if the formula implies \a x or -x
+    inline var_t substitute(var_t x);
+    /// Records that the formula implies \a x, later gate inputs over it fold to constants
+    void assert_unit(var_t x);
+    /// Records that the formula implies a == b, later gate inputs over b are replaced by a or
+    /// the other way round. Units and equivalences that contradict earlier ones are ignored
+    void assert_equivalent(var_t a, var_t b);
+    /// Returns the number of variables replaced by another literal or a constant
+    inline uint32_t num_substituted() const noexcept { return m_num_substituted; }
     /// Allocates \a number many solver variables and returns the first one
     inline var_t new_vars(int number) noexcept;
     /// Allocates and returns a new solver variable
@@ -60,6 +138,10 @@ public:
     virtual var_t make_xor(var_t a, var_t b) = 0;
     /// Creates a new variable representing MUX(s, t, e)
     virtual var_t make_mux(var_t s, var_t t, var_t e) = 0;
+    /// Creates a new variable representing XOR(a, b, c)
+    virtual var_t make_xor3(var_t a, var_t b, var_t c) = 0;
+    /// Creates a new variable representing MAJ(a, b, c)
+    virtual var_t make_maj(var_t a, var_t b, var_t c) = 0;
 
     /// Only default constructor is implemented
     VarManager();
@@ -74,6 +156,14 @@ inline var_t VarManager::new_vars(const int number) noexcept
     return as_var(var + 1);
 }
 
+inline var_t VarManager::substitute(var_t x)
+{
+    if (m_num_substituted == 0 || is_const(x)) return x;
+    const size_t var = static_cast<size_t>(as_int(abs_var_t(x)));
+    if (var >= m_repr.size() || m_repr[var] == var_t::ILLEGAL) return x;
+    return find_representative(x);
+}
+
 } // namespace cxxsat
 
 #endif // CXXSAT_VARMANAGER_H
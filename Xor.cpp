@@ -0,0 +1,165 @@
+#include "Solver.h"
+#include <vector>
+#include <algorithm>
+
+using cxxsat::Solver;
+using cxxsat::var_t;
+using cxxsat::parity_t;
+using cxxsat::XorSystem;
+
+void Solver::add_xor(const std::vector<var_t>& lits, bool rhs)
+{
+    const call_scope_t scope(*this);
+    if (scope.traced())
+    {
+        trace_lits(trace_op_t::XOR_CONSTRAINT, lits.data(), lits.size());
+        m_trace->write_uint(rhs ? 1 : 0);
+    }
+    for (const var_t x : lits)
+    {
+        Assert(is_legal(x), ILLEGAL_LITERAL);
+        Assert(is_known(x), UNKNOWN_LITERAL);
+    }
+    m_state = STATE_INPUT;
+    parity_t parity = {{}, rhs};
+    for (var_t x : lits)
+    {
+        x = substitute(x);
+        if (is_const(x))
+        {
+            parity.rhs = parity.rhs != (x == var_t::ONE);
+            continue;
+        }
+        parity.rhs = parity.rhs != is_negated(x);
+        parity.vars.push_back(abs_var_t(x));
+    }
+    // Repeated variables cancel out
+    std::sort(parity.vars.begin(), parity.vars.end());
+    size_t num = 0;
+    for (size_t i = 0; i < parity.vars.size(); i++)
+    {
+        if (i + 1 < parity.vars.size() && parity.vars[i] == parity.vars[i + 1]) i++;
+        else parity.vars[num++] = parity.vars[i];
+    }
+    parity.vars.resize(num);
+    if (!parity.vars.empty()) m_xors.push_back(std::move(parity));
+    else if (parity.rhs) add_clause(var_t::ZERO);
+}
+
+void Solver::encode_parity(const std::vector<var_t>& vars, bool rhs)
+{
+    if (vars.size() == 1) add_clause(rhs ? vars[0] : -vars[0]);
+    else if (vars.size() == 2) add_equivalence(vars[0], rhs ? -vars[1] : vars[1]);
+    else
+    {
+        const var_t r = make_xor(vars);
+        add_clause(rhs ? r : -r);
+    }
+}
+
+void Solver::emit_xors()
+{
+    if (m_xors.empty()) return;
+    const call_scope_t scope(*this);
+    std::vector<parity_t> implied;
+    for (const parity_t& parity : m_xors)
+    {
+        switch (m_xor_system.add(parity.vars, parity.rhs))
+        {
+        case XorSystem::REDUNDANT: m_num_redundant_xors += 1; continue;
+        case XorSystem::CONFLICT: add_clause(var_t::ZERO); continue;
+        default: encode_parity(parity.vars, parity.rhs); break;
+        }
+        // Later Jordan steps may lengthen the short rows again, so they are taken right away
+        for (parity_t& row : m_xor_system.take_implied()) implied.push_back(std::move(row));
+    }
+    DEBUG(1) << "reduced " << m_xors.size() << " XOR constraints, rank " << m_xor_system.rank()
+             << " over " << m_xor_system.num_columns() << " variables" << std::endl;
+    m_xors.clear();
+
+    // The elimination may combine long constraints into short ones, which are worth knowing
+    for (const parity_t& parity : implied)
+    {
+        const var_t a = substitute(parity.vars[0]);
+        if (parity.vars.size() == 1 && is_const(a)) continue;
+        if (parity.vars.size() == 2 && abs_var_t(a) == abs_var_t(substitute(parity.vars[1]))) continue;
+        encode_parity(parity.vars, parity.rhs);
+    }
+}
+
+namespace {
+
+/// Auxiliary variables are charged like this many literals
+constexpr uint64_t XOR_VAR_COST = 16;
+
+/// Returns the cost of an XOR over \a num_ins inputs, following the chunking of make_xor
+uint64_t xor_cost(size_t num_ins, cxxsat::xor_shape_t shape, uint32_t width)
+{
+    // A chunk of k inputs has 2^k clauses over k + 1 literals and one output
+    auto chunk_cost = [](size_t k) { return ((static_cast<uint64_t>(k) + 1) << k) + XOR_VAR_COST; };
+    uint64_t cost = 0;
+    if (shape == cxxsat::xor_shape_t::CHAIN)
+    {
+        size_t i = std::min<size_t>(width, num_ins);
+        cost += chunk_cost(i);
+        for (; i < num_ins; i = std::min<size_t>(num_ins, i + width - 1))
+            cost += chunk_cost(1 + std::min<size_t>(width - 1, num_ins - i));
+        return cost;
+    }
+    for (size_t level = num_ins; level != 1; level = (level + width - 1) / width)
+    {
+        cost += (level / width) * chunk_cost(width);
+        if (level % width > 1) cost += chunk_cost(level % width);
+    }
+    return cost;
+}
+
+} // namespace
+
+void Solver::set_xor_encoding(xor_shape_t shape, uint32_t width)
+{
+    Assert(width == 0 || (width >= 2 && width <= MAX_XOR_WIDTH), ILLEGAL_XOR_WIDTH);
+    m_xor_shape = shape;
+    m_xor_width = width;
+}
+
+std::pair<cxxsat::xor_shape_t, uint32_t> Solver::xor_encoding(size_t num_ins) const
+{
+    if (m_xor_shape != xor_shape_t::AUTO && m_xor_width != 0) return {m_xor_shape, m_xor_width};
+    std::pair<xor_shape_t, uint32_t> best = {xor_shape_t::TREE, 2};
+    uint64_t best_cost = UINT64_MAX;
+    for (const xor_shape_t shape : {xor_shape_t::TREE, xor_shape_t::CHAIN})
+    {
+        if (m_xor_shape != xor_shape_t::AUTO && shape != m_xor_shape) continue;
+        for (uint32_t width = 2; width <= MAX_XOR_WIDTH; width++)
+        {
+            if (m_xor_width != 0 && width != m_xor_width) continue;
+            // Wider chunks than inputs cost the same as a single chunk
+            if (width > num_ins && width > 2) break;
+            const uint64_t cost = xor_cost(num_ins, shape, width);
+            if (cost >= best_cost) continue;
+            best_cost = cost;
+            best = {shape, width};
+        }
+    }
+    return best;
+}
+
+void Solver::encode_xor_chunk(const std::vector<var_t>& ins, var_t r)
+{
+    // Each clause forbids one assignment of the inputs together with the wrong output
+    const size_t size = ins.size();
+    std::vector<var_t> clause(size + 1);
+    for (uint32_t comb = 0; comb < (1u << size); comb++)
+    {
+        bool odd = false;
+        for (size_t j = 0; j < size; j++)
+        {
+            const bool sign = (comb >> j) & 1;
+            clause[j] = sign ? -ins[j] : ins[j];
+            odd = odd != sign;
+        }
+        clause[size] = odd ? r : -r;
+        add_clause(clause);
+    }
+}
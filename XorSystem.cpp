@@ -0,0 +1,117 @@
+#include "XorSystem.h"
+
+using cxxsat::XorSystem;
+using cxxsat::parity_t;
+using cxxsat::var_t;
+
+namespace {
+
+constexpr uint32_t WORD_BITS = 64;
+
+/// Sets a ^= b, extending a with zeros if it is shorter
+void xor_into(std::vector<uint64_t>& a, const std::vector<uint64_t>& b)
+{
+    if (a.size() < b.size()) a.resize(b.size(), 0);
+    for (size_t i = 0; i < b.size(); i++) a[i] ^= b[i];
+}
+
+/// Returns the index of the lowest set bit of a nonzero \a word
+inline uint32_t lowest_bit(uint64_t word)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<uint32_t>(__builtin_ctzll(word));
+#else
+    uint32_t bit = 0;
+    if ((word & 0xffffffffu) == 0) { word >>= 32; bit += 32; }
+    if ((word & 0xffffu) == 0) { word >>= 16; bit += 16; }
+    if ((word & 0xffu) == 0) { word >>= 8; bit += 8; }
+    if ((word & 0xfu) == 0) { word >>= 4; bit += 4; }
+    if ((word & 0x3u) == 0) { word >>= 2; bit += 2; }
+    return bit + static_cast<uint32_t>((word & 1) == 0);
+#endif
+}
+
+} // namespace
+
+uint32_t XorSystem::column(var_t var)
+{
+    const auto res = m_column_of.emplace(as_int(var), static_cast<uint32_t>(m_vars.size()));
+    if (res.second)
+    {
+        m_vars.push_back(var);
+        m_pivot_row.push_back(NO_ROW);
+    }
+    return res.first->second;
+}
+
+uint32_t XorSystem::columns_of(const row_t& row, std::vector<uint32_t>* cols) const
+{
+    uint32_t num = 0;
+    for (size_t w = 0; w < row.bits.size(); w++)
+    {
+        for (uint64_t word = row.bits[w]; word != 0; word &= word - 1)
+        {
+            num += 1;
+            if (cols != nullptr) cols->push_back(static_cast<uint32_t>(w) * WORD_BITS + lowest_bit(word));
+        }
+    }
+    return num;
+}
+
+XorSystem::result_t XorSystem::add(const std::vector<var_t>& vars, bool rhs)
+{
+    row_t row = {{}, rhs, false};
+    for (const var_t x : vars)
+    {
+        const uint32_t col = column(x);
+        if (row.bits.size() <= col / WORD_BITS) row.bits.resize(col / WORD_BITS + 1, 0);
+        row.bits[col / WORD_BITS] ^= uint64_t(1) << (col % WORD_BITS);
+    }
+
+    // The other rows are zero in every leading column, so eliminating one never sets another
+    for (size_t w = 0; w < row.bits.size(); w++)
+    {
+        for (uint64_t word = row.bits[w]; word != 0; word &= word - 1)
+        {
+            const uint32_t r = m_pivot_row[static_cast<uint32_t>(w) * WORD_BITS + lowest_bit(word)];
+            if (r == NO_ROW) continue;
+            xor_into(row.bits, m_rows[r].bits);
+            row.rhs ^= m_rows[r].rhs;
+        }
+    }
+    uint32_t lead = NO_ROW;
+    for (size_t w = 0; w < row.bits.size() && lead == NO_ROW; w++)
+        if (row.bits[w] != 0) lead = static_cast<uint32_t>(w) * WORD_BITS + lowest_bit(row.bits[w]);
+    if (lead == NO_ROW) return row.rhs ? CONFLICT : REDUNDANT;
+
+    // Jordan step, which keeps the leading column of the new row zero in all other rows
+    const size_t word = lead / WORD_BITS;
+    const uint64_t mask = uint64_t(1) << (lead % WORD_BITS);
+    for (row_t& other : m_rows)
+    {
+        if (other.bits.size() <= word || (other.bits[word] & mask) == 0) continue;
+        xor_into(other.bits, row.bits);
+        other.rhs ^= row.rhs;
+        other.taken = false;
+    }
+    m_pivot_row[lead] = static_cast<uint32_t>(m_rows.size());
+    m_rows.push_back(std::move(row));
+    return INDEPENDENT;
+}
+
+std::vector<parity_t> XorSystem::take_implied()
+{
+    std::vector<parity_t> implied;
+    std::vector<uint32_t> cols;
+    for (row_t& row : m_rows)
+    {
+        if (row.taken || columns_of(row, nullptr) > 2) continue;
+        row.taken = true;
+        cols.clear();
+        columns_of(row, &cols);
+        parity_t parity = {{}, row.rhs};
+        for (const uint32_t col : cols) parity.vars.push_back(m_vars[col]);
+        implied.push_back(std::move(parity));
+    }
+    return implied;
+}
@@ -0,0 +1,59 @@
+#ifndef CXXSAT_XOR_SYSTEM_H
+#define CXXSAT_XOR_SYSTEM_H
+
+#include "vars.h"
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+
+namespace cxxsat {
+
+/// Parity constraint XOR(vars) == rhs over distinct positive variables
+struct parity_t {
+    std::vector<var_t> vars;
+    bool rhs;
+};
+
+/// Linear system over GF(2) kept in reduced row echelon form by Gauss-Jordan elimination.
+/// Rows are bit-packed into 64-bit words over the columns, one column per variable, so a row
+/// operation XORs whole words, which the compiler vectorizes
+class XorSystem {
+private:
+    static constexpr uint32_t NO_ROW = UINT32_MAX;
+
+    struct row_t {
+        std::vector<uint64_t> bits;
+        bool rhs;
+        /// True once the row was returned by take_implied, reset whenever the row changes
+        bool taken;
+    };
+
+    std::vector<row_t> m_rows;
+    /// Variable of each column, and the column of each variable
+    std::vector<var_t> m_vars;
+    std::unordered_map<int32_t, uint32_t> m_column_of;
+    /// Row whose leading column is the column, or NO_ROW
+    std::vector<uint32_t> m_pivot_row;
+
+    /// Returns the column of \a var, adding one if needed
+    uint32_t column(var_t var);
+    /// Returns the number of columns of \a row and writes them to \a cols if not null
+    uint32_t columns_of(const row_t& row, std::vector<uint32_t>* cols) const;
+public:
+    enum result_t {INDEPENDENT, REDUNDANT, CONFLICT};
+
+    /// Adds XOR(vars) == rhs for distinct positive variables. Returns REDUNDANT if the system
+    /// already implies it and CONFLICT if it contradicts the system, neither changes the system
+    result_t add(const std::vector<var_t>& vars, bool rhs);
+    /// Returns the units and equivalences of the system not returned before
+    std::vector<parity_t> take_implied();
+
+    /// Returns the number of independent constraints
+    inline size_t rank() const noexcept { return m_rows.size(); }
+    /// Returns the number of variables in the constraints
+    inline size_t num_columns() const noexcept { return m_vars.size(); }
+};
+
+} // namespace cxxsat
+
+#endif // CXXSAT_XOR_SYSTEM_H
@@ -0,0 +1,135 @@
+#include "gate_keys.h"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <cmath>
+
+using cxxsat::as_int;
+
+/// The former binary key hash, packing both literals
+struct identity_hash {
+    uint64_t operator()(const binary_key_t& key) const noexcept
+    {
+        return ((uint64_t) as_int(std::get<1>(key)) << 32) | (uint64_t) as_int(std::get<0>(key));
+    }
+};
+
+/// Portable byte-wise baseline
+template<typename Key>
+struct fnv1a_hash {
+    uint64_t operator()(const Key& key) const noexcept
+    {
+        const unsigned char* data = reinterpret_cast<const unsigned char*>(key.data());
+        uint64_t h = UINT64_C(0xcbf29ce484222325);
+        for (size_t i = 0; i < key.size() * sizeof(var_t); i++) h = (h ^ data[i]) * UINT64_C(0x100000001b3);
+        return h;
+    }
+};
+
+#ifdef __GLIBCXX__
+/// The former ternary key hash, only available with libstdc++
+template<typename Key>
+struct libstdcxx_hash {
+    uint64_t operator()(const Key& key) const noexcept
+    {
+        return std::_Hash_impl::hash(key.data(), key.size() * sizeof(var_t));
+    }
+};
+#endif
+
+/// Counts the keys that land in an already occupied bucket of a table with 2^bits buckets
+template<typename Index>
+size_t bucket_collisions(const std::vector<uint64_t>& hashes, uint32_t bits, Index&& index)
+{
+    std::vector<bool> used(size_t(1) << bits, false);
+    size_t res = 0;
+    for (uint64_t h : hashes)
+    {
+        const size_t i = index(h);
+        res += used[i];
+        used[i] = true;
+    }
+    return res;
+}
+
+template<typename Hash, typename Key>
+void run(const std::string& name, const std::vector<Key>& keys)
+{
+    const Hash hash;
+    uint64_t sink = 0;
+    const double throughput = mops(keys.size(), [&]() {
+        for (const Key& key : keys) sink += hash(key);
+    });
+
+    std::vector<uint64_t> hashes;
+    hashes.reserve(keys.size());
+    for (const Key& key : keys) hashes.push_back(hash(key));
+
+    uint32_t bits = 0;
+    while ((size_t(1) << bits) < keys.size()) bits += 1;
+    const size_t low = bucket_collisions(hashes, bits, [&](uint64_t h) { return h & ((size_t(1) << bits) - 1); });
+    const size_t high = bucket_collisions(hashes, bits, [&](uint64_t h) { return h >> (64 - bits); });
+
+    std::sort(hashes.begin(), hashes.end());
+    const size_t full = hashes.size() - (std::unique(hashes.begin(), hashes.end()) - hashes.begin());
+
+    std::cout << std::left << std::setw(20) << name << std::right << std::fixed << std::setprecision(2)
+              << std::setw(10) << throughput << std::setw(10) << full << std::setw(12) << low
+              << std::setw(12) << high << "   (" << (sink & 1) << ")" << std::endl;
+}
+
+/// Expected bucket collisions of a random function mapping \a n keys into \a m buckets
+double expected_collisions(size_t n, size_t m)
+{
+    return n - m * (1.0 - std::pow(1.0 - 1.0 / m, double(n)));
+}
+
+template<typename Key, typename... Hashes>
+void header(const std::string& name, const std::vector<Key>& keys)
+{
+    size_t m = 1;
+    while (m < keys.size()) m *= 2;
+    std::cout << name << ", " << keys.size() << " keys, random function expects "
+              << std::fixed << std::setprecision(0) << expected_collisions(keys.size(), m)
+              << " bucket collisions" << std::endl;
+    std::cout << std::left << std::setw(20) << "hash" << std::right << std::setw(10) << "Mhash/s"
+              << std::setw(10) << "full" << std::setw(12) << "low bits" << std::setw(12) << "high bits"
+              << std::endl;
+}
+
+template<typename Key>
+void bench_binary(const std::string& name, const std::vector<Key>& keys)
+{
+    header(name, keys);
+    run<identity_hash>("identity", keys);
+    run<fnv1a_hash<Key>>("fnv1a", keys);
+#ifdef __GLIBCXX__
+    run<libstdcxx_hash<Key>>("_Hash_impl", keys);
+#endif
+    run<std::hash<Key>>("mix", keys);
+    std::cout << std::endl;
+}
+
+template<typename Key>
+void bench_ternary(const std::string& name, const std::vector<Key>& keys)
+{
+    header(name, keys);
+    run<fnv1a_hash<Key>>("fnv1a", keys);
+#ifdef __GLIBCXX__
+    run<libstdcxx_hash<Key>>("_Hash_impl", keys);
+#endif
+    run<std::hash<Key>>("mix", keys);
+    std::cout << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t count = (argc > 1) ? std::stoull(argv[1]) : (size_t(1) << 22);
+    std::mt19937_64 rng(42);
+    bench_binary("binary circuit keys", make_keys<2>(count, rng));
+    bench_binary("binary sequential keys", make_sequential_keys<2>(count));
+    bench_ternary("ternary circuit keys", make_keys<3>(count, rng));
+    bench_ternary("ternary sequential keys", make_sequential_keys<3>(count));
+    return 0;
+}
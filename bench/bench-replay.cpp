@@ -0,0 +1,55 @@
+#include "Solver.h"
+#include "Trace.h"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+
+using cxxsat::Solver;
+using cxxsat::trace_phase_t;
+
+/// Replays a trace on a fresh solver and prints the wall time of every phase
+int replay(const std::string& path)
+{
+    Solver solver;
+    const std::vector<trace_phase_t> phases = cxxsat::replay_trace(solver, path);
+
+    std::cout << path << std::endl;
+    std::cout << std::left << std::setw(8) << "phase" << std::setw(10) << "kind" << std::right
+              << std::setw(12) << "ops" << std::setw(12) << "seconds" << std::setw(8) << "state" << std::endl;
+    double encode = 0, solve = 0;
+    for (size_t i = 0; i < phases.size(); i++)
+    {
+        const trace_phase_t& phase = phases[i];
+        (phase.solve ? solve : encode) += phase.seconds;
+        std::cout << std::left << std::setw(8) << i << std::setw(10) << (phase.solve ? "solve" : "encode")
+                  << std::right << std::setw(12) << phase.num_ops << std::fixed << std::setprecision(4)
+                  << std::setw(12) << phase.seconds << std::setw(8);
+        if (phase.solve) std::cout << phase.state;
+        else std::cout << "";
+        std::cout << std::endl;
+    }
+    std::cout << "encode " << std::fixed << std::setprecision(4) << encode << " s, solve " << solve
+              << " s, " << solver.num_vars() << " variables, " << solver.num_clauses() << " clauses"
+              << std::endl << std::endl;
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cout << "Usage: " << argv[0] << " TRACE..." << std::endl;
+        return 1;
+    }
+    for (int i = 1; i < argc; i++)
+    {
+        try { replay(argv[i]); }
+        catch (const std::exception& e)
+        {
+            std::cerr << argv[i] << ": " << e.what() << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
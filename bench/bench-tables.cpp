@@ -0,0 +1,95 @@
+#include "gate_keys.h"
+
+#include <unordered_map>
+#include <iostream>
+#include <iomanip>
+#include <string>
+
+using cxxsat::GateTable;
+using cxxsat::as_var;
+using cxxsat::as_int;
+
+/// Bytes currently held by all counting_allocator instances
+size_t g_live_bytes = 0;
+
+/// Allocator tracking the live heap usage of the node-based maps
+template<typename T>
+struct counting_allocator {
+    using value_type = T;
+    counting_allocator() = default;
+    template<typename U>
+    counting_allocator(const counting_allocator<U>&) noexcept { }
+
+    T* allocate(size_t n)
+    {
+        g_live_bytes += n * sizeof(T);
+        return std::allocator<T>().allocate(n);
+    }
+    void deallocate(T* p, size_t n) noexcept
+    {
+        g_live_bytes -= n * sizeof(T);
+        std::allocator<T>().deallocate(p, n);
+    }
+    template<typename U>
+    bool operator==(const counting_allocator<U>&) const noexcept { return true; }
+    template<typename U>
+    bool operator!=(const counting_allocator<U>&) const noexcept { return false; }
+};
+
+template<typename Key>
+using node_map_t = std::unordered_map<Key, var_t, std::hash<Key>, std::equal_to<Key>,
+                                      counting_allocator<std::pair<const Key, var_t>>>;
+
+template<typename Map, typename Key>
+void run(const std::string& name, const std::vector<Key>& keys, const std::vector<Key>& probes,
+         const std::vector<Key>& misses, size_t (*bytes)(const Map&))
+{
+    Map map;
+    const double insert = mops(keys.size(), [&]() {
+        for (size_t i = 0; i < keys.size(); i++) map.emplace(keys[i], as_var(static_cast<int32_t>(i + 1)));
+    });
+    size_t found = 0;
+    const double hit = mops(probes.size(), [&]() {
+        for (const Key& key : probes) found += (map.find(key) != map.end());
+    });
+    const double miss = mops(misses.size(), [&]() {
+        for (const Key& key : misses) found += (map.find(key) != map.end());
+    });
+    std::cout << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(2)
+              << std::setw(10) << insert << std::setw(10) << hit << std::setw(10) << miss
+              << std::setw(12) << double(bytes(map)) / map.size()
+              << "   (" << found << " found)" << std::endl;
+}
+
+template<size_t N>
+void bench(const std::string& name, size_t count, std::mt19937_64& rng)
+{
+    using key_t = std::array<var_t, N>;
+    const std::vector<key_t> keys = make_keys<N>(count, rng);
+    std::vector<key_t> probes = keys;
+    std::shuffle(probes.begin(), probes.end(), rng);
+    // Keys over variables beyond the generated range are never present
+    std::vector<key_t> misses = probes;
+    const int32_t offset = 1 << 30;
+    for (key_t& key : misses)
+        key[0] = as_var(as_int(key[0]) < 0 ? as_int(key[0]) - offset : as_int(key[0]) + offset);
+
+    std::cout << name << " keys, " << count << " gates" << std::endl;
+    std::cout << std::left << std::setw(24) << "table" << std::right << std::setw(10) << "insert"
+              << std::setw(10) << "hit" << std::setw(10) << "miss" << std::setw(12) << "bytes/gate"
+              << "   [Mops/s]" << std::endl;
+    run<node_map_t<key_t>>("std::unordered_map", keys, probes, misses,
+                           [](const node_map_t<key_t>&) { return g_live_bytes; });
+    run<GateTable<key_t>>("GateTable", keys, probes, misses,
+                          [](const GateTable<key_t>& map) { return map.memory_usage(); });
+    std::cout << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t count = (argc > 1) ? std::stoull(argv[1]) : (size_t(1) << 22);
+    std::mt19937_64 rng(42);
+    bench<2>("binary", count, rng);
+    bench<3>("ternary", count, rng);
+    return 0;
+}
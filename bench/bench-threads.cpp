@@ -0,0 +1,84 @@
+#include "Solver.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <thread>
+#include <vector>
+
+using cxxsat::Solver;
+using cxxsat::var_t;
+
+/// Builds an array multiplier of two \a width bit numbers through the operators and returns its number of clauses
+int build_multiplier(uint32_t width)
+{
+    Solver solver;
+    const cxxsat::SolverScope scope(solver);
+    std::vector<var_t> a, b;
+    for (uint32_t i = 0; i < width; i++) a.push_back(solver.new_var());
+    for (uint32_t i = 0; i < width; i++) b.push_back(solver.new_var());
+
+    std::vector<var_t> acc(2 * width, var_t::ZERO);
+    for (uint32_t i = 0; i < width; i++)
+    {
+        var_t carry = var_t::ZERO;
+        for (uint32_t j = 0; j < width; j++)
+        {
+            const var_t x = acc[i + j];
+            const var_t y = a[j] & b[i];
+            acc[i + j] = x ^ y ^ carry;
+            carry = cxxsat::mux(x ^ y, carry, x);
+        }
+        acc[i + width] = carry;
+    }
+    solver.flush();
+    return solver.num_clauses();
+}
+
+/// Splits \a num_jobs multipliers over \a num_threads threads, each with its own solver, and prints the wall time
+double run(uint32_t num_threads, uint32_t num_jobs, uint32_t width, double base)
+{
+    using clock = std::chrono::steady_clock;
+    std::vector<long> clauses(num_threads, 0);
+    const auto start = clock::now();
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < num_threads; t++)
+    {
+        threads.emplace_back([t, num_threads, num_jobs, width, &clauses]() {
+            for (uint32_t job = t; job < num_jobs; job += num_threads) clauses[t] += build_multiplier(width);
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    const double seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+    long total = 0;
+    for (const long num : clauses) total += num;
+    const double speedup = (base > 0) ? base / seconds : 1.0;
+    std::cout << std::setw(8) << num_threads << std::setw(12) << total << std::fixed << std::setprecision(4)
+              << std::setw(10) << seconds << std::setprecision(2) << std::setw(10) << speedup
+              << std::setw(12) << speedup / num_threads << std::endl;
+    return seconds;
+}
+
+int main(int argc, char* argv[])
+{
+    const uint32_t max_threads = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1]))
+                                          : std::max(1u, std::thread::hardware_concurrency());
+    const uint32_t num_jobs = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 256;
+    const uint32_t width = argc > 3 ? static_cast<uint32_t>(std::stoul(argv[3])) : 24;
+    if (max_threads == 0 || width == 0)
+    {
+        std::cout << "Usage: " << argv[0] << " [THREADS [JOBS [WIDTH]]] with THREADS, WIDTH > 0" << std::endl;
+        return 1;
+    }
+
+    std::cout << num_jobs << " multipliers of width " << width << " on up to " << max_threads << " threads" << std::endl;
+    std::cout << std::setw(8) << "threads" << std::setw(12) << "clauses" << std::setw(10) << "seconds"
+              << std::setw(10) << "speedup" << std::setw(12) << "efficiency" << std::endl;
+    const double base = run(1, num_jobs, width, 0);
+    for (uint32_t num_threads = 2; num_threads <= max_threads; num_threads *= 2)
+        run(num_threads, num_jobs, width, base);
+    return 0;
+}
@@ -0,0 +1,97 @@
+#include "Solver.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <vector>
+
+using cxxsat::Solver;
+using cxxsat::var_t;
+using cxxsat::xor_shape_t;
+
+/// Random system of XOR constraints that a hidden assignment satisfies
+struct instance_t {
+    uint32_t num_vars;
+    std::vector<std::vector<uint32_t>> xors;
+    std::vector<bool> rhs;
+};
+
+instance_t make_instance(uint32_t num_vars, uint32_t num_xors, uint32_t length, uint64_t seed)
+{
+    std::mt19937_64 rng(seed);
+    std::vector<bool> hidden;
+    for (uint32_t i = 0; i < num_vars; i++) hidden.push_back(rng() & 1);
+    instance_t inst = {num_vars, {}, {}};
+    for (uint32_t j = 0; j < num_xors; j++)
+    {
+        std::vector<uint32_t> vars;
+        bool rhs = false;
+        while (vars.size() < length)
+        {
+            const uint32_t v = static_cast<uint32_t>(rng() % num_vars);
+            if (std::find(vars.begin(), vars.end(), v) != vars.end()) continue;
+            vars.push_back(v);
+            rhs = rhs != hidden[v];
+        }
+        inst.xors.push_back(vars);
+        inst.rhs.push_back(rhs);
+    }
+    return inst;
+}
+
+/// Encodes the instance with the given chunking through make_xor and solves it
+void run(const instance_t& inst, xor_shape_t shape, uint32_t width)
+{
+    using clock = std::chrono::steady_clock;
+    Solver solver;
+    solver.set_xor_encoding(shape, width);
+    const auto start = clock::now();
+    const var_t first = solver.new_vars(static_cast<int>(inst.num_vars));
+    std::vector<var_t> ins;
+    for (size_t j = 0; j < inst.xors.size(); j++)
+    {
+        ins.clear();
+        for (const uint32_t v : inst.xors[j]) ins.push_back(cxxsat::as_var(cxxsat::as_int(first) + static_cast<int32_t>(v)));
+        const var_t r = solver.make_xor(ins);
+        solver.add_clause(inst.rhs[j] ? r : -r);
+    }
+    solver.flush();
+    const double encode = std::chrono::duration<double>(clock::now() - start).count();
+    const auto solve_start = clock::now();
+    const int state = solver.check();
+    const double solve = std::chrono::duration<double>(clock::now() - solve_start).count();
+
+    const char* name = shape == xor_shape_t::CHAIN ? "chain" : shape == xor_shape_t::TREE ? "tree" : "auto";
+    std::cout << std::left << std::setw(8) << name << std::right << std::setw(6);
+    if (width == 0) std::cout << "-";
+    else std::cout << width;
+    std::cout << std::setw(10) << solver.num_vars() << std::setw(10) << solver.num_clauses()
+              << std::fixed << std::setprecision(4) << std::setw(10) << encode << std::setw(10) << solve
+              << std::setw(6) << state << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    const uint32_t num_vars = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : 48;
+    const uint32_t num_xors = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 44;
+    const uint32_t length = argc > 3 ? static_cast<uint32_t>(std::stoul(argv[3])) : 12;
+    const uint64_t seed = argc > 4 ? std::stoull(argv[4]) : 1;
+    if (length > num_vars)
+    {
+        std::cout << "Usage: " << argv[0] << " [VARS [XORS [LENGTH [SEED]]]] with LENGTH <= VARS" << std::endl;
+        return 1;
+    }
+    const instance_t inst = make_instance(num_vars, num_xors, length, seed);
+
+    std::cout << num_xors << " XORs of length " << length << " over " << num_vars << " variables" << std::endl;
+    std::cout << std::left << std::setw(8) << "shape" << std::right << std::setw(6) << "width" << std::setw(10)
+              << "vars" << std::setw(10) << "clauses" << std::setw(10) << "encode" << std::setw(10) << "solve"
+              << std::setw(6) << "state" << std::endl;
+    run(inst, xor_shape_t::AUTO, 0);
+    for (const xor_shape_t shape : {xor_shape_t::CHAIN, xor_shape_t::TREE})
+        for (uint32_t width = 2; width <= 8; width++) run(inst, shape, width);
+    return 0;
+}
@@ -0,0 +1,62 @@
+#ifndef CXXSAT_BENCH_GATE_KEYS_H
+#define CXXSAT_BENCH_GATE_KEYS_H
+
+#include "GateTable.h"
+#include "keys.h"
+
+#include <vector>
+#include <array>
+#include <random>
+#include <chrono>
+#include <algorithm>
+
+/// Generates distinct gate keys shaped like a structurally hashed circuit, where
+/// inputs are mostly recent gate outputs with random polarity
+template<size_t N>
+std::vector<std::array<var_t, N>> make_keys(size_t count, std::mt19937_64& rng)
+{
+    using cxxsat::as_var;
+    using cxxsat::as_int;
+    std::vector<std::array<var_t, N>> keys;
+    keys.reserve(count);
+    cxxsat::GateTable<std::array<var_t, N>> seen;
+    int32_t num_vars = 64;
+    while (keys.size() < count)
+    {
+        std::array<var_t, N> key;
+        for (size_t i = 0; i < N; i++)
+        {
+            const int32_t back = std::min<int32_t>(num_vars - 1, std::geometric_distribution<int32_t>(0.001)(rng));
+            const int32_t var = num_vars - back;
+            key[i] = (rng() & 1) ? as_var(var) : as_var(-var);
+        }
+        std::sort(key.begin(), key.end(), [](var_t a, var_t b) { return as_int(a) < as_int(b); });
+        if (!seen.emplace(key, as_var(num_vars + 1)).second) continue;
+        keys.push_back(key);
+        num_vars += 1;
+    }
+    return keys;
+}
+
+/// Generates the keys of a chain of gates over consecutive variables, (1, 2), (2, 3), ...
+template<size_t N>
+std::vector<std::array<var_t, N>> make_sequential_keys(size_t count)
+{
+    std::vector<std::array<var_t, N>> keys(count);
+    for (size_t i = 0; i < count; i++)
+        for (size_t j = 0; j < N; j++)
+            keys[i][j] = cxxsat::as_var(static_cast<int32_t>(i + j + 1));
+    return keys;
+}
+
+/// Runs \a func and returns the throughput of \a count operations in millions per second
+template<typename F>
+double mops(size_t count, F&& func)
+{
+    const auto start = std::chrono::steady_clock::now();
+    func();
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return count / elapsed.count() / 1e6;
+}
+
+#endif // CXXSAT_BENCH_GATE_KEYS_H
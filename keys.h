@@ -2,18 +2,67 @@
 #define CXXSAT_KEYS_H
 
 #include "vars.h"
+#include <array>
+#include <vector>
 #include <functional>
 
 using cxxsat::var_t;
 using binary_key_t = std::array<var_t, 2>;
 using ternary_key_t = std::array<var_t, 3>;
+using nary_key_t = std::vector<var_t>;
+
+namespace cxxsat {
+
+/// Secrets of the key mixing, odd constants with balanced bits as in wyhash
+constexpr uint64_t KEY_SECRET_0 = UINT64_C(0xa0761d6478bd642f);
+constexpr uint64_t KEY_SECRET_1 = UINT64_C(0xe7037ed1a0b428db);
+constexpr uint64_t KEY_SECRET_2 = UINT64_C(0x8ebc6af09c88c6e3);
+
+/// Multiplies \a a and \a b to 128 bits and folds the halves with XOR
+inline uint64_t key_mum(uint64_t a, uint64_t b) noexcept
+{
+#ifdef __SIZEOF_INT128__
+    const unsigned __int128 r = static_cast<unsigned __int128>(a) * b;
+    return static_cast<uint64_t>(r) ^ static_cast<uint64_t>(r >> 64);
+#else
+    const uint64_t ha = a >> 32, hb = b >> 32, la = static_cast<uint32_t>(a), lb = static_cast<uint32_t>(b);
+    const uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    const uint64_t t = rl + (rm0 << 32);
+    const uint64_t lo = t + (rm1 << 32);
+    const uint64_t hi = rh + (rm0 >> 32) + (rm1 >> 32) + (t < rl) + (lo < t);
+    return lo ^ hi;
+#endif
+}
+
+/// Packs two literals into one word, \a a in the low half
+inline constexpr uint64_t key_pack(var_t a, var_t b) noexcept
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(as_int(b))) << 32) | static_cast<uint32_t>(as_int(a));
+}
+
+/// Hashes the literals data[0..size)
+inline uint64_t key_hash(const var_t* data, size_t size) noexcept
+{
+    uint64_t h = KEY_SECRET_0 ^ size;
+    size_t i = 0;
+    for (; i + 1 < size; i += 2)
+        h = key_mum(key_pack(data[i], data[i + 1]) ^ KEY_SECRET_1, h ^ KEY_SECRET_2);
+    if (i < size)
+        h = key_mum(key_pack(data[i], var_t::ILLEGAL) ^ KEY_SECRET_1, h ^ KEY_SECRET_2);
+    return key_mum(KEY_SECRET_1 ^ size, h ^ KEY_SECRET_0);
+}
+
+} // namespace cxxsat
 
 template<>
 struct std::hash<binary_key_t>
 {
     uint64_t operator()(const binary_key_t& key) const noexcept
     {
-        return ((uint64_t) as_int(std::get<1>(key)) << 32) | (uint64_t) as_int(std::get<0>(key));
+        using namespace cxxsat;
+        const uint64_t a = key_pack(std::get<0>(key), std::get<1>(key));
+        const uint64_t b = key_pack(std::get<1>(key), std::get<0>(key));
+        return key_mum(KEY_SECRET_1 ^ 8, key_mum(a ^ KEY_SECRET_1, b ^ KEY_SECRET_0));
     }
 };
 
@@ -22,7 +71,19 @@ struct std::hash<ternary_key_t>
 {
     uint64_t operator()(const ternary_key_t& key) const noexcept
     {
-        return std::_Hash_impl::hash(key.data(), key.size() * sizeof(var_t));
+        using namespace cxxsat;
+        const uint64_t a = key_pack(std::get<0>(key), std::get<1>(key));
+        const uint64_t b = key_pack(std::get<2>(key), std::get<0>(key)) ^ KEY_SECRET_2;
+        return key_mum(KEY_SECRET_1 ^ 12, key_mum(a ^ KEY_SECRET_1, b ^ KEY_SECRET_0));
+    }
+};
+
+template<>
+struct std::hash<nary_key_t>
+{
+    uint64_t operator()(const nary_key_t& key) const noexcept
+    {
+        return cxxsat::key_hash(key.data(), key.size());
     }
 };
 
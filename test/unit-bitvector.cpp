@@ -0,0 +1,215 @@
+#include "BitVector.h"
+
+#ifdef NDEBUG
+#define assert(cond) do { if (!(cond)) return 3; } while (0)
+#else
+#include <cassert>
+#endif
+
+#include <iostream>
+#include <map>
+#include <random>
+
+using test_func_t = int (*)();
+using Solver = cxxsat::Solver;
+using BitVector = cxxsat::BitVector;
+using var_t = cxxsat::var_t;
+const uint32_t TEST_WIDTH = 4;
+const uint32_t NUM_RANDOM_ROWS = 256;
+
+void assume_value(Solver& solver, const BitVector& a, uint64_t value)
+{
+    for (uint32_t i = 0; i < a.width(); i++)
+        solver.assume(((value >> i) & 1) ? +a[i] : -a[i]);
+}
+
+int64_t as_signed(uint64_t value, uint32_t width)
+{
+    const uint64_t sign = uint64_t(1) << (width - 1);
+    return static_cast<int64_t>(value ^ sign) - static_cast<int64_t>(sign);
+}
+
+int test_bv_structure()
+{
+    BitVector a = BitVector::constant(0b1011, 4);
+    assert(a.width() == 4);
+    assert(a[0] == var_t::ONE && a[2] == var_t::ZERO);
+
+    assert(a.extract(2, 1) == BitVector::constant(0b01, 2));
+    assert(a.extract(3, 3) == BitVector::constant(0b1, 1));
+    assert(a.concat(BitVector::constant(0b10, 2)) == BitVector::constant(0b101110, 6));
+    assert(a.zext(6) == BitVector::constant(0b001011, 6));
+    assert(a.sext(6) == BitVector::constant(0b111011, 6));
+    assert(a.shl(1) == BitVector::constant(0b0110, 4));
+    assert(a.lshr(1) == BitVector::constant(0b0101, 4));
+    assert(a.ashr(2) == BitVector::constant(0b1110, 4));
+    assert(a.shl(7) == BitVector::constant(0, 4));
+    assert(~a == BitVector::constant(0b0100, 4));
+
+    return 0;
+}
+
+int test_bv_arith()
+{
+    Solver solver;
+
+    BitVector a = BitVector::fresh(solver, TEST_WIDTH);
+    BitVector b = BitVector::fresh(solver, TEST_WIDTH);
+
+    BitVector sum = cxxsat::bv_add(solver, a, b);
+    BitVector diff = cxxsat::bv_sub(solver, a, b);
+    BitVector neg = cxxsat::bv_neg(solver, a);
+    BitVector prod = cxxsat::bv_mul(solver, a, b);
+    BitVector quot = cxxsat::bv_udiv(solver, a, b);
+    BitVector rem = cxxsat::bv_urem(solver, a, b);
+
+    const uint64_t mask = (1 << TEST_WIDTH) - 1;
+    for (uint64_t va = 0; va <= mask; va++)
+        for (uint64_t vb = 0; vb <= mask; vb++)
+        {
+            assume_value(solver, a, va);
+            assume_value(solver, b, vb);
+            assert(Solver::state_t::STATE_SAT == solver.check());
+
+            std::cout << va << " op " << vb << std::endl;
+            assert(cxxsat::bv_value(solver, sum) == ((va + vb) & mask));
+            assert(cxxsat::bv_value(solver, diff) == ((va - vb) & mask));
+            assert(cxxsat::bv_value(solver, neg) == ((0 - va) & mask));
+            assert(cxxsat::bv_value(solver, prod) == ((va * vb) & mask));
+            assert(cxxsat::bv_value(solver, quot) == (vb == 0 ? mask : va / vb));
+            assert(cxxsat::bv_value(solver, rem) == (vb == 0 ? va : va % vb));
+        }
+
+    return 0;
+}
+
+int test_bv_compare()
+{
+    Solver solver;
+
+    BitVector a = BitVector::fresh(solver, TEST_WIDTH);
+    BitVector b = BitVector::fresh(solver, TEST_WIDTH);
+
+    var_t eq = cxxsat::bv_eq(solver, a, b);
+    var_t ult = cxxsat::bv_ult(solver, a, b);
+    var_t ule = cxxsat::bv_ule(solver, a, b);
+    var_t slt = cxxsat::bv_slt(solver, a, b);
+    var_t sle = cxxsat::bv_sle(solver, a, b);
+
+    const uint64_t mask = (1 << TEST_WIDTH) - 1;
+    for (uint64_t va = 0; va <= mask; va++)
+        for (uint64_t vb = 0; vb <= mask; vb++)
+        {
+            assume_value(solver, a, va);
+            assume_value(solver, b, vb);
+            assert(Solver::state_t::STATE_SAT == solver.check());
+
+            const int64_t sa = as_signed(va, TEST_WIDTH), sb = as_signed(vb, TEST_WIDTH);
+            std::cout << va << " cmp " << vb << std::endl;
+            assert(solver.value(eq) == (va == vb));
+            assert(solver.value(ult) == (va < vb));
+            assert(solver.value(ule) == (va <= vb));
+            assert(solver.value(slt) == (sa < sb));
+            assert(solver.value(sle) == (sa <= sb));
+        }
+
+    return 0;
+}
+
+int test_bv_shift()
+{
+    Solver solver;
+
+    BitVector a = BitVector::fresh(solver, TEST_WIDTH);
+    BitVector amount = BitVector::fresh(solver, TEST_WIDTH - 1);
+
+    BitVector shl = cxxsat::bv_shl(solver, a, amount);
+    BitVector lshr = cxxsat::bv_lshr(solver, a, amount);
+    BitVector ashr = cxxsat::bv_ashr(solver, a, amount);
+
+    const uint64_t mask = (1 << TEST_WIDTH) - 1;
+    for (uint64_t va = 0; va <= mask; va++)
+        for (uint64_t vs = 0; vs < (uint64_t(1) << amount.width()); vs++)
+        {
+            assume_value(solver, a, va);
+            assume_value(solver, amount, vs);
+            assert(Solver::state_t::STATE_SAT == solver.check());
+
+            const int64_t sa = as_signed(va, TEST_WIDTH);
+            std::cout << va << " shift " << vs << std::endl;
+            assert(cxxsat::bv_value(solver, shl) == (vs < TEST_WIDTH ? (va << vs) & mask : 0));
+            assert(cxxsat::bv_value(solver, lshr) == (vs < TEST_WIDTH ? va >> vs : 0));
+            assert(cxxsat::bv_value(solver, ashr) == (uint64_t(sa >> std::min<uint64_t>(vs, TEST_WIDTH - 1)) & mask));
+        }
+
+    return 0;
+}
+
+int test_bv_sharing()
+{
+    Solver solver;
+
+    const uint32_t width = 3 * TEST_WIDTH;
+    BitVector a = BitVector::fresh(solver, width);
+    BitVector b = BitVector::fresh(solver, width);
+
+    BitVector prod = cxxsat::bv_mul(solver, a, b);
+    BitVector quot = cxxsat::bv_udiv(solver, a, b);
+
+    // Rebuilding the same words only hits the gate caches
+    const int nc = solver.num_clauses();
+    const int nv = solver.num_vars();
+    assert(prod == cxxsat::bv_mul(solver, a, b));
+    assert(quot == cxxsat::bv_udivrem(solver, a, b).first);
+    assert(nc == solver.num_clauses());
+    assert(nv == solver.num_vars());
+
+    const uint64_t mask = (1 << width) - 1;
+    std::mt19937_64 rng(0x5eed);
+    for (uint32_t row = 0; row < NUM_RANDOM_ROWS; row++)
+    {
+        const uint64_t va = rng() & mask, vb = rng() & mask;
+        assume_value(solver, a, va);
+        assume_value(solver, b, vb);
+        assert(Solver::state_t::STATE_SAT == solver.check());
+
+        std::cout << va << " * " << vb << " = " << cxxsat::bv_value(solver, prod) << std::endl;
+        assert(cxxsat::bv_value(solver, prod) == ((va * vb) & mask));
+        assert(cxxsat::bv_value(solver, quot) == (vb == 0 ? mask : va / vb));
+    }
+
+    return 0;
+}
+
+const std::map<const std::string, test_func_t> tests = {
+    {"test_bv_structure", test_bv_structure},
+    {"test_bv_arith", test_bv_arith},
+    {"test_bv_compare", test_bv_compare},
+    {"test_bv_shift", test_bv_shift},
+    {"test_bv_sharing", test_bv_sharing}
+};
+
+int main(int argc, const char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cout << "Usage: " << argv[0] << " TEST_NAME" << std::endl;
+        return 1;
+    }
+
+    if (argv[1] == std::string("all"))
+    {
+        int res = 0;
+        for (const auto& test : tests)
+            { res |= test.second(); }
+        return res;
+    }
+
+    const auto& test_it = tests.find(argv[1]);
+    if (test_it == tests.end())
+    {
+        std::cout << "Unknown test \"" << argv[1] << "\"" << std::endl;
+        return 2;
+    }
+    return test_it->second();
+}
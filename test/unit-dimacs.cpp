@@ -0,0 +1,318 @@
+#include "Solver.h"
+#include "DimacsWriter.h"
+#include "DimacsReader.h"
+
+#ifdef NDEBUG
+#define assert(cond) do { if (!(cond)) return 3; } while (0)
+#else
+#include <cassert>
+#endif
+
+#ifdef CXXSAT_HAS_ZLIB
+#include <zlib.h>
+#endif
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <vector>
+#include <random>
+
+using test_func_t = int (*)();
+using Solver = cxxsat::Solver;
+using DimacsWriter = cxxsat::DimacsWriter;
+using var_t = cxxsat::var_t;
+
+std::string read_file(const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream text;
+    text << in.rdbuf();
+    return text.str();
+}
+
+/// Returns the text of \a path with comment lines removed
+std::string strip_comments(const std::string& text)
+{
+    std::istringstream in(text);
+    std::string line, res;
+    while (std::getline(in, line))
+        if (line.empty() || line[0] != 'c') res += line + "\n";
+    return res;
+}
+
+int test_format_literal()
+{
+    const std::vector<int32_t> lits = {1, -1, 10, -2147483647, 2147483647, 123456789, 0};
+    char text[128];
+    char* out = text;
+    for (const int32_t lit : lits) out = cxxsat::format_literal(out, lit);
+    assert(std::string(text, out) == "1 -1 10 -2147483647 2147483647 123456789 0\n");
+    return 0;
+}
+
+int test_writer_plain()
+{
+    const std::string path = "unit-dimacs-plain.cnf";
+    {
+        DimacsWriter writer(path);
+        const std::vector<int32_t> lits = {1, -2, 0, 3, 0};
+        writer.write(lits.data(), lits.size());
+        writer.write_clause({cxxsat::as_var(-7), cxxsat::as_var(2)});
+        assert(writer.num_clauses() == 3 && writer.max_var() == 7);
+        writer.close(9);
+        assert(!writer.is_open());
+    }
+    const std::string text = read_file(path);
+    assert(text.size() > 64 && text[0] == 'c');
+    assert(strip_comments(text) == "p cnf 9 3\n1 -2 0\n3 0\n-7 2 0\n");
+
+    // Large formulas pass through the buffer several times
+    {
+        DimacsWriter writer(path);
+        std::vector<int32_t> lits;
+        for (int32_t i = 1; i <= 500000; i++) lits.insert(lits.end(), {i, -(i + 1), 0});
+        writer.write(lits.data(), lits.size());
+    }
+    std::istringstream in(strip_comments(read_file(path)));
+    std::string p, cnf;
+    uint64_t num_vars, num_clauses;
+    in >> p >> cnf >> num_vars >> num_clauses;
+    assert(p == "p" && cnf == "cnf" && num_vars == 500001 && num_clauses == 500000);
+    for (int32_t i = 1; i <= 500000; i++)
+    {
+        int32_t a, b, z;
+        in >> a >> b >> z;
+        assert(a == i && b == -(i + 1) && z == 0);
+    }
+    return 0;
+}
+
+int test_writer_gzip()
+{
+#ifdef CXXSAT_HAS_ZLIB
+    const std::string path = "unit-dimacs-gzip.cnf.gz";
+    std::string expected = "p cnf 200000 100000\n";
+    {
+        DimacsWriter writer(path, DimacsWriter::compression_t::GZIP);
+        std::vector<int32_t> lits;
+        for (int32_t i = 1; i <= 100000; i++)
+        {
+            lits.insert(lits.end(), {-i, i + 100000, 0});
+            expected += std::to_string(-i) + " " + std::to_string(i + 100000) + " 0\n";
+        }
+        writer.write(lits.data(), lits.size());
+        writer.close();
+    }
+    // zlib reads all gzip members in sequence
+    gzFile in = gzopen(path.c_str(), "rb");
+    assert(in != nullptr);
+    std::string text;
+    char chunk[1 << 16];
+    int num;
+    while ((num = gzread(in, chunk, sizeof(chunk))) > 0) text.append(chunk, num);
+    gzclose(in);
+    assert(strip_comments(text) == expected);
+#else
+    try { DimacsWriter writer("unit-dimacs-gzip.cnf.gz", DimacsWriter::compression_t::GZIP); }
+    catch (const std::runtime_error&) { return 0; }
+    assert(false);
+#endif
+    return 0;
+}
+
+int test_solver_writer()
+{
+    const std::string path = "unit-dimacs-solver.cnf";
+    Solver solver;
+    std::ostringstream stream;
+    DimacsWriter writer(path);
+    solver.set_stream(&stream);
+    solver.set_writer(&writer);
+
+    var_t a = solver.new_var();
+    var_t b = solver.new_var();
+    solver.make_and(a, b);
+    solver.add_clause(a);
+    assert(Solver::state_t::STATE_SAT == solver.check());
+    solver.new_var();
+    solver.add_clause(-b, var_t::ZERO);
+    solver.clear_writer();
+    writer.close(solver.num_vars());
+
+    const std::string clauses = "1 -3 0\n2 -3 0\n-1 -2 3 0\n1 0\n-2 0\n";
+    assert(strip_comments(read_file(path)) == "p cnf 4 5\n" + clauses);
+    solver.clear_stream();
+    assert(stream.str() == clauses);
+
+    // A formula built only for its output keeps its buffered clauses on destruction
+    std::ostringstream dumped;
+    {
+        Solver dump;
+        dump.set_stream(&dumped);
+        const var_t x = dump.new_var();
+        dump.add_clause(x, -dump.new_var());
+    }
+    assert(dumped.str() == "1 -2 0\n");
+    return 0;
+}
+
+void write_file(const std::string& path, const std::string& text)
+{
+    std::ofstream out(path, std::ios::binary);
+    out << text;
+}
+
+int test_reader()
+{
+    const std::string path = "unit-dimacs-reader.cnf";
+    // Clauses spanning lines, comments and a final end marker
+    write_file(path, "c example\nc\np cnf 3  4 \n1 -2\n 0 2 3 0\nc inner comment\n-1\t0\n-2 0\n%\n0\n");
+
+    Solver solver;
+    solver.new_vars(5);
+    const cxxsat::dimacs_info_t info = cxxsat::load_dimacs(solver, path);
+    assert(info.num_vars == 3 && info.num_clauses == 4 && info.num_read == 4);
+    assert(info.first_var == cxxsat::as_var(6) && solver.num_vars() == 8);
+    assert(solver.num_clauses() == 4);
+
+    // File variables 1, 2, 3 are solver variables 6, 7, 8
+    assert(Solver::state_t::STATE_SAT == solver.check());
+    assert(!solver.value(cxxsat::as_var(6)) && !solver.value(cxxsat::as_var(7)) && solver.value(cxxsat::as_var(8)));
+    return 0;
+}
+
+int test_reader_chunks()
+{
+    // Random 3-SAT large enough to be split, with clauses broken over lines
+    const std::string path = "unit-dimacs-chunks.cnf";
+    const int32_t num_vars = 20000;
+    const uint32_t num_clauses = 400000;
+    std::mt19937 rng(1);
+    std::vector<int32_t> lits;
+    std::string text = "p cnf " + std::to_string(num_vars) + " " + std::to_string(num_clauses) + "\n";
+    for (uint32_t i = 0; i < num_clauses; i++)
+    {
+        for (uint32_t j = 0; j < 3; j++)
+        {
+            const int32_t var = static_cast<int32_t>(rng() % num_vars) + 1;
+            const int32_t lit = (rng() & 1) ? var : -var;
+            lits.push_back(lit);
+            text += std::to_string(lit) + ((rng() % 5 == 0) ? "\n" : " ");
+        }
+        lits.push_back(0);
+        text += "0\n";
+    }
+    write_file(path, text);
+
+    Solver solver;
+    std::ostringstream parsed;
+    solver.set_stream(&parsed);
+    const cxxsat::dimacs_info_t info = cxxsat::load_dimacs(solver, path, 4);
+    solver.clear_stream();
+    assert(info.num_read == num_clauses && solver.num_clauses() == static_cast<int>(num_clauses));
+
+    std::string expected;
+    char buffer[16];
+    for (const int32_t lit : lits)
+        expected.append(buffer, cxxsat::format_literal(buffer, lit));
+    assert(parsed.str() == expected);
+    return 0;
+}
+
+int test_reader_gates()
+{
+    // Circuit written by one solver is reloaded into another with its gates
+    const std::string path = "unit-dimacs-gates.cnf";
+    var_t a, b, c, g_and, g_xor, g_mux;
+    {
+        Solver solver;
+        DimacsWriter writer(path);
+        solver.set_writer(&writer);
+        a = solver.new_var(), b = solver.new_var(), c = solver.new_var();
+        g_and = solver.make_and(a, b);
+        g_xor = solver.make_xor(b, c);
+        g_mux = solver.make_mux(g_and, g_xor, c);
+        solver.clear_writer();
+        writer.close(solver.num_vars());
+    }
+
+    Solver solver;
+    cxxsat::load_dimacs(solver, path, 1, true);
+    assert(!solver.is_recording());
+    const int nv = solver.num_vars(), nc = solver.num_clauses();
+    assert(solver.make_and(b, a) == g_and);
+    assert(solver.make_xor(c, b) == g_xor);
+    assert(solver.make_mux(solver.make_and(a, b), g_xor, c) == g_mux);
+    assert(nv == solver.num_vars() && nc == solver.num_clauses());
+    return 0;
+}
+
+int test_reader_errors()
+{
+    const std::vector<std::pair<std::string, std::string>> bad = {
+        {"1 2 0\n", "Missing DIMACS header"},
+        {"p cnf 2 1\n1 3 0\n", "Variable exceeds the header"},
+        {"p cnf 2 1\n1 99999999999999999999 0\n", "Variable exceeds the header"},
+        {"p cnf 2 1\n1 x 0\n", "Unexpected character"},
+        {"p cnf 2 1\n12abc 0\n", "Unexpected character"},
+        {"p cnf 2 1\n1-2 0\n", "Unexpected character"},
+        {"p cnf 2 1\n1 2\n", "is not terminated"},
+        {"p cnf 2 2\n1 0\n2\n", "is not terminated"},
+        {"p cnf 2 1 extra\n1 2 0\n", "Unexpected text after DIMACS header"}
+    };
+    const std::string path = "unit-dimacs-errors.cnf";
+    for (const auto& entry : bad)
+    {
+        write_file(path, entry.first);
+        Solver solver;
+        bool thrown = false;
+        try { cxxsat::load_dimacs(solver, path); }
+        catch (const std::runtime_error& e)
+        {
+            thrown = true;
+            std::cout << e.what() << std::endl;
+            assert(std::string(e.what()).find(entry.second) != std::string::npos);
+        }
+        // Rejected files leave the solver untouched
+        assert(thrown && solver.num_clauses() == 0 && solver.num_vars() == 0);
+    }
+    return 0;
+}
+
+const std::map<const std::string, test_func_t> tests = {
+    {"test_format_literal", test_format_literal},
+    {"test_writer_plain", test_writer_plain},
+    {"test_writer_gzip", test_writer_gzip},
+    {"test_solver_writer", test_solver_writer},
+    {"test_reader", test_reader},
+    {"test_reader_chunks", test_reader_chunks},
+    {"test_reader_gates", test_reader_gates},
+    {"test_reader_errors", test_reader_errors}
+};
+
+int main(int argc, const char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cout << "Usage: " << argv[0] << " TEST_NAME" << std::endl;
+        return 1;
+    }
+
+    if (argv[1] == std::string("all"))
+    {
+        int res = 0;
+        for (const auto& test : tests)
+            { res |= test.second(); }
+        return res;
+    }
+
+    const auto& test_it = tests.find(argv[1]);
+    if (test_it == tests.end())
+    {
+        std::cout << "Unknown test \"" << argv[1] << "\"" << std::endl;
+        return 2;
+    }
+    return test_it->second();
+}
@@ -1,4 +1,9 @@
 #include "Solver.h"
+#include "Totalizer.h"
+#include "GateTable.h"
+#include "Trace.h"
+#include "Aiger.h"
+#include "XorSystem.h"
 
 #ifdef NDEBUG
 #define assert(cond) do { if (!(cond)) return 3; } while (0)
@@ -6,14 +11,24 @@
 #include <cassert>
 #endif
 
+#include <algorithm>
 #include <iostream>
 #include <map>
+#include <random>
+#include <unordered_map>
 #include <unordered_set>
+#include <sstream>
+#include <fstream>
+#include <thread>
 
 using test_func_t = int (*)();
 using Solver = cxxsat::Solver;
 using var_t = cxxsat::var_t;
+using card_encoding_t = cxxsat::card_encoding_t;
+using pb_encoding_t = cxxsat::pb_encoding_t;
+using amo_encoding_t = cxxsat::amo_encoding_t;
 const uint32_t MAX_VECTOR_TEST = 8;
+const uint32_t NUM_RANDOM_ROWS = 64;
 
 
 int test_and()
@@ -298,6 +313,76 @@ int test_mux()
     return 0;
 }
 
+int exhaustive_ternary(Solver& solver, var_t a, var_t b, var_t c, var_t r, bool (*expected)(bool, bool, bool))
+{
+    for (int row = 0; row < 8; row++)
+    {
+        bool pos_a = row & 1;
+        bool pos_b = row & 2;
+        bool pos_c = row & 4;
+
+        solver.assume(pos_a ? +a : -a);
+        solver.assume(pos_b ? +b : -b);
+        solver.assume(pos_c ? +c : -c);
+        assert(Solver::state_t::STATE_SAT == solver.check());
+
+        std::cout << pos_a << ", " << pos_b << ", " << pos_c << " == " << solver.value(r) << std::endl;
+        assert(solver.value(r) == expected(pos_a, pos_b, pos_c));
+    }
+    return 0;
+}
+
+int test_xor3()
+{
+    Solver solver;
+
+    var_t a = solver.new_var();
+    var_t b = solver.new_var();
+    var_t c = solver.new_var();
+
+    assert(solver.make_xor(b, c) == solver.make_xor3(var_t::ZERO, b, c));
+    assert(-solver.make_xor(a, c) == solver.make_xor3(a, var_t::ONE, c));
+    assert(c == solver.make_xor3(a, a, c));
+    assert(-b == solver.make_xor3(a, b, -a));
+
+    var_t r = solver.make_xor3(a, b, c);
+    assert(r == solver.make_xor3(c, a, b));
+    assert(r == solver.make_xor3(-a, -b, c));
+    assert(-r == solver.make_xor3(b, -c, a));
+
+    assert(!exhaustive_ternary(solver, a, b, c, r,
+        [](bool x, bool y, bool z) { return x != (y != z); }));
+
+    return 0;
+}
+
+int test_maj()
+{
+    Solver solver;
+
+    var_t a = solver.new_var();
+    var_t b = solver.new_var();
+    var_t c = solver.new_var();
+
+    assert(solver.make_or(b, c) == solver.make_maj(var_t::ONE, b, c));
+    assert(solver.make_and(a, c) == solver.make_maj(a, var_t::ZERO, c));
+    assert(a == solver.make_maj(a, b, a));
+    assert(b == solver.make_maj(a, b, -a));
+
+    var_t r = solver.make_maj(a, b, c);
+    assert(r == solver.make_maj(c, a, b));
+    assert(-r == solver.make_maj(-a, -c, -b));
+    var_t q = solver.make_maj(-a, b, c);
+    assert(q != r && q != -r);
+
+    assert(!exhaustive_ternary(solver, a, b, c, r,
+        [](bool x, bool y, bool z) { return (x + y + z) >= 2; }));
+    assert(!exhaustive_ternary(solver, a, b, c, q,
+        [](bool x, bool y, bool z) { return (!x + y + z) >= 2; }));
+
+    return 0;
+}
+
 int test_and_multi()
 {
     Solver solver;
@@ -380,6 +465,697 @@ int test_or_multi()
     return 0;
 }
 
+int test_xor_multi()
+{
+    Solver solver;
+
+    std::vector<var_t> ins;
+    var_t res;
+
+    res = solver.make_xor(ins);
+    assert(res == var_t::ZERO);
+
+    ins.push_back(solver.new_var());
+    res = solver.make_xor(ins);
+    assert(res == ins[0]);
+
+    ins.push_back(solver.new_var());
+    res = solver.make_xor(ins);
+    assert(res == solver.make_xor(ins[0], ins[1]));
+
+    do {
+        ins.push_back(solver.new_var());
+        // Negating an input negates the output
+        ins.back() = -ins.back();
+        res = solver.make_xor(ins);
+        for (uint32_t row = 0; row < (1u << ins.size()); row++)
+        {
+            bool expected = false;
+            for (uint32_t pos_i = 0; pos_i < ins.size(); pos_i++)
+            {
+                bool pos = row & (1 << pos_i);
+                solver.assume(pos ? +ins[pos_i] : -ins[pos_i]);
+                std::cout << pos << ((pos_i == ins.size() - 1) ? " == " : " ^ ");
+                expected ^= pos;
+            }
+            assert(Solver::state_t::STATE_SAT == solver.check());
+            std::cout << expected << std::endl;
+            assert(solver.value(res) == expected);
+        }
+        ins.back() = -ins.back();
+    } while(ins.size() != MAX_VECTOR_TEST + 2);
+
+    return 0;
+}
+
+int test_nary_cache()
+{
+    Solver solver;
+
+    std::vector<var_t> ins;
+    for (uint32_t i = 0; i < 5; i++) ins.push_back(solver.new_var());
+
+    // Permuted, duplicated and padded inputs share one AND gate
+    const var_t r = solver.make_and(ins);
+    int nc = solver.num_clauses();
+    std::vector<var_t> perm = {ins[3], ins[1], var_t::ONE, ins[4], ins[0], ins[2], ins[1]};
+    assert(solver.make_and(perm) == r);
+    assert(solver.make_or({-ins[4], -ins[3], -ins[2], -ins[1], -ins[0]}) == -r);
+    assert(nc == solver.num_clauses());
+
+    // Complementary inputs and constants fold
+    assert(solver.make_and({ins[0], ins[1], -ins[0]}) == var_t::ZERO);
+    assert(solver.make_and({ins[2], var_t::ONE, ins[2]}) == ins[2]);
+    assert(solver.make_and({ins[2], ins[1], ins[2]}) == solver.make_and(ins[1], ins[2]));
+    assert(solver.make_or({ins[0], var_t::ONE, ins[3]}) == var_t::ONE);
+
+    // XOR gates match up to permutation, negation and cancelling pairs
+    const var_t x = solver.make_xor(ins);
+    nc = solver.num_clauses();
+    assert(solver.make_xor({ins[4], ins[2], ins[0], ins[3], ins[1]}) == x);
+    assert(solver.make_xor({-ins[4], ins[2], ins[0], ins[3], ins[1]}) == -x);
+    assert(solver.make_xor({ins[4], ins[2], var_t::ONE, ins[0], ins[3], ins[1]}) == -x);
+    assert(solver.make_xor({ins[4], ins[2], ins[0], ins[3], ins[1], ins[2], -ins[2]}) == -x);
+    assert(nc == solver.num_clauses());
+    assert(solver.make_xor({ins[0], ins[1], ins[0], -ins[1]}) == var_t::ONE);
+    assert(solver.make_xor({ins[0], ins[1], ins[1]}) == ins[0]);
+    assert(solver.make_xor({ins[0], -ins[1], ins[1], ins[2]}) == -solver.make_xor(ins[0], ins[2]));
+
+    const cxxsat::solver_stats_t stats = solver.stats();
+    assert(stats[cxxsat::gate_kind_t::AND_N].inserts == 1);
+    assert(stats[cxxsat::gate_kind_t::XOR_N].inserts == 1);
+    assert(stats[cxxsat::gate_kind_t::XOR_N].hits == 4);
+    return 0;
+}
+
+int test_detect_gates()
+{
+    Solver solver;
+    solver.new_vars(9);
+    // 5 = AND(1, 2), 6 = OR(3, 4, -1), 7 = XOR(2, 3), 8 = MUX(1, 3, 4), 9 = XNOR(3, 4)
+    const std::vector<int32_t> lits = {
+        -5, 1, 0, -5, 2, 0, 5, -1, -2, 0,
+        -6, 3, 4, -1, 0, 6, -3, 0, 6, -4, 0, 6, 1, 0,
+        -7, 2, 3, 0, -7, -2, -3, 0, 7, -2, 3, 0, 7, 2, -3, 0,
+        -1, -3, 8, 0, -1, 3, -8, 0, 1, -4, 8, 0, 1, 4, -8, 0,
+        9, 3, 4, 0, 9, -3, -4, 0, -9, -3, 4, 0, -9, 3, -4, 0
+    };
+    auto v = [](int32_t x) { return cxxsat::as_var(x); };
+
+    // Gates found by a single detection pass over the raw clauses
+    assert(solver.detect_gates(lits.data(), lits.size()) == 5);
+    assert(solver.make_and(v(1), v(2)) == v(5));
+    assert(solver.make_or({v(3), v(4), v(-1)}) == v(6));
+    assert(solver.make_xor(v(3), v(2)) == v(7));
+    assert(solver.make_mux(v(1), v(3), v(4)) == v(8));
+    assert(solver.make_xor(v(3), v(4)) == v(-9));
+    assert(solver.num_vars() == 9 && solver.num_clauses() == 0);
+
+    // Gates found among recorded clauses added one by one
+    Solver recorded;
+    recorded.new_vars(9);
+    recorded.set_recording(true);
+    std::vector<var_t> clause;
+    for (const int32_t lit : lits)
+    {
+        if (lit != 0) { clause.push_back(v(lit)); continue; }
+        recorded.add_clause(clause);
+        clause.clear();
+    }
+    assert(recorded.detect_gates() == 5);
+    recorded.set_recording(false);
+    const int nc = recorded.num_clauses();
+    assert(recorded.make_xor({v(4), v(3)}) == v(-9));
+    assert(recorded.make_mux(v(-1), v(4), v(3)) == v(8));
+    assert(recorded.make_and({v(2), v(1)}) == v(5));
+    assert(nc == recorded.num_clauses());
+    assert(Solver::state_t::STATE_SAT == recorded.check());
+    assert(recorded.value(v(7)) == (recorded.value(v(2)) ^ recorded.value(v(3))));
+
+    // Clauses that only resemble gates are ignored
+    const std::vector<int32_t> partial = {-5, 1, 0, 5, -1, -2, 0, -7, 2, 3, 0, -7, -2, -3, 0, 7, -2, 3, 0};
+    Solver other;
+    other.new_vars(9);
+    assert(other.detect_gates(partial.data(), partial.size()) == 0);
+    return 0;
+}
+
+int test_substitution()
+{
+    Solver solver;
+    std::vector<var_t> v;
+    for (uint32_t i = 0; i < 8; i++) v.push_back(solver.new_var());
+
+    // Units fold the gates over them
+    solver.add_clause(v[0]);
+    int nc = solver.num_clauses();
+    assert(solver.make_and(v[0], v[1]) == v[1]);
+    assert(solver.make_or(-v[0], v[2]) == v[2]);
+    assert(solver.make_and({v[0], v[1], -v[0]}) == var_t::ZERO);
+    assert(solver.make_at_most({v[0], v[1]}, 0) == var_t::ZERO);
+    solver.add_clause(v[0], v[3]);
+    assert(nc == solver.num_clauses());
+
+    // Equivalences replace the newer variable
+    solver.add_equivalence(v[1], -v[2]);
+    nc = solver.num_clauses();
+    assert(solver.substitute(v[2]) == -v[1]);
+    assert(solver.make_and(v[1], v[2]) == var_t::ZERO);
+    assert(solver.make_xor(v[2], v[1]) == var_t::ONE);
+    assert(solver.make_mux(v[3], v[2], v[4]) == solver.make_mux(v[3], -v[1], v[4]));
+    solver.add_equivalence(-v[2], v[1]);
+    assert(nc + 6 == solver.num_clauses());
+
+    // A unit on an XOR output relates its inputs
+    const var_t x = solver.make_xor(v[5], v[6]);
+    solver.add_clause(-x);
+    assert(solver.substitute(v[6]) == v[5]);
+    nc = solver.num_clauses();
+    assert(solver.make_and(v[5], -v[6]) == var_t::ZERO);
+    assert(solver.make_or(v[6], v[5]) == v[5]);
+    assert(nc == solver.num_clauses());
+
+    // Clauses are rewritten, so units arise from longer clauses
+    solver.add_clause(-v[0], v[7]);
+    assert(solver.substitute(v[7]) == var_t::ONE);
+    // v[0], v[2], x, v[6] and v[7]
+    assert(solver.num_substituted() == 5);
+
+    assert(Solver::state_t::STATE_SAT == solver.check());
+    assert(solver.value(v[0]) && solver.value(v[7]));
+    assert(solver.value(v[1]) != solver.value(v[2]));
+    assert(solver.value(v[5]) == solver.value(v[6]));
+    return 0;
+}
+
+int test_harvest_fixed()
+{
+    Solver solver;
+    const var_t a = solver.new_var(), b = solver.new_var(), c = solver.new_var();
+    // Raw clauses are not simplified, so only the backend learns that b and c are fixed
+    const int32_t lits[] = {as_int(a), 0, -as_int(a), as_int(b), 0, -as_int(b), -as_int(c), 0};
+    solver.add_clauses(lits, sizeof(lits) / sizeof(lits[0]));
+    assert(solver.substitute(a) == var_t::ONE);
+    assert(solver.substitute(b) == b);
+    assert(solver.is_harvesting_fixed());
+    assert(Solver::state_t::STATE_SAT == solver.check());
+    assert(solver.value(b) && !solver.value(c));
+#ifdef CXXSAT_BACKEND_CADICAL
+    assert(solver.substitute(b) == var_t::ONE);
+    assert(solver.substitute(c) == var_t::ZERO);
+    const int nc = solver.num_clauses();
+    assert(solver.make_and(b, -c) == var_t::ONE);
+    assert(nc == solver.num_clauses());
+#else
+    assert(solver.substitute(b) == b);
+#endif
+    assert(solver.harvest_fixed() == 0);
+
+    // Variables fixed by later checks are found, but only after solving
+    const var_t d = solver.new_var(), e = solver.new_var();
+    const int32_t later[] = {as_int(d), 0, -as_int(d), -as_int(e), 0};
+    solver.add_clauses(later, sizeof(later) / sizeof(later[0]));
+    assert(solver.harvest_fixed() == 0);
+    assert(Solver::state_t::STATE_SAT == solver.check());
+    assert(!solver.value(e));
+#ifdef CXXSAT_BACKEND_CADICAL
+    assert(solver.substitute(e) == var_t::ZERO);
+#endif
+
+    Solver other;
+    other.set_harvest_fixed(false);
+    const var_t x = other.new_var(), y = other.new_var();
+    const int32_t more[] = {as_int(x), 0, -as_int(x), as_int(y), 0};
+    other.add_clauses(more, sizeof(more) / sizeof(more[0]));
+    assert(Solver::state_t::STATE_SAT == other.check());
+    assert(other.substitute(y) == y);
+#ifdef CXXSAT_BACKEND_CADICAL
+    assert(other.harvest_fixed() == 1);
+    assert(other.substitute(y) == var_t::ONE);
+#endif
+    return 0;
+}
+
+/// Builds random circuits over five inputs in \a random and checks every output against a
+/// simulation under a random assignment of the inputs, over several incremental checks
+int random_circuits(Solver& random, uint64_t seed)
+{
+    std::mt19937_64 rng(seed);
+    std::vector<var_t> ins, outs;
+    std::vector<std::pair<uint32_t, std::array<var_t, 4>>> gates;
+    for (uint32_t i = 0; i < 5; i++) ins.push_back(random.new_var());
+    auto pick = [&]() {
+        const var_t lit = (rng() % 4 == 0 || outs.empty()) ? ins[rng() % ins.size()] : outs[rng() % outs.size()];
+        return rng() % 2 ? -lit : lit;
+    };
+    for (uint32_t round = 0; round < 16; round++)
+    {
+        for (uint32_t i = 0; i < 24; i++)
+        {
+            const var_t a = pick(), b = pick(), c = pick(), d = pick();
+            const uint32_t op = rng() % 7;
+            switch (op)
+            {
+            case 0: outs.push_back(random.make_and(a, b)); break;
+            case 1: outs.push_back(random.make_or(a, b)); break;
+            case 2: outs.push_back(random.make_xor(a, b)); break;
+            case 3: outs.push_back(random.make_mux(a, b, c)); break;
+            case 4: outs.push_back(random.make_xor3(a, b, c)); break;
+            case 5: outs.push_back(random.make_maj(a, b, c)); break;
+            default: outs.push_back(random.make_and({a, b, c, d})); break;
+            }
+            gates.push_back({op, {a, b, c, d}});
+        }
+        // Reference an output from a clause, which keeps its node from being inlined
+        random.add_clause(random.new_var(), outs[rng() % outs.size()]);
+        const uint64_t row = rng();
+        for (uint32_t i = 0; i < ins.size(); i++) random.assume((row >> i) & 1 ? ins[i] : -ins[i]);
+        assert(Solver::state_t::STATE_SAT == random.check());
+        for (uint32_t i = 0; i < ins.size(); i++) assert(random.value(ins[i]) == ((row >> i) & 1));
+
+        // Simulate the requested gates, rewritten outputs are older literals that must agree
+        std::unordered_map<int32_t, bool> sim;
+        for (uint32_t i = 0; i < ins.size(); i++) sim[as_int(ins[i])] = (row >> i) & 1;
+        auto sim_value = [&](var_t lit) {
+            if (is_const(lit)) return lit == var_t::ONE;
+            return sim.at(as_int(abs_var_t(lit))) != is_negated(lit);
+        };
+        for (size_t j = 0; j < gates.size(); j++)
+        {
+            const auto& in = gates[j].second;
+            const bool a = sim_value(in[0]), b = sim_value(in[1]), c = sim_value(in[2]), d = sim_value(in[3]);
+            bool expected;
+            switch (gates[j].first)
+            {
+            case 0: expected = a && b; break;
+            case 1: expected = a || b; break;
+            case 2: expected = a != b; break;
+            case 3: expected = a ? b : c; break;
+            case 4: expected = (a != b) != c; break;
+            case 5: expected = (a + b + c) >= 2; break;
+            default: expected = a && b && c && d; break;
+            }
+            if (!is_const(outs[j]) && sim.count(as_int(abs_var_t(outs[j]))) == 0)
+                sim[as_int(abs_var_t(outs[j]))] = expected != is_negated(outs[j]);
+            assert(sim_value(outs[j]) == expected);
+            assert(random.value(outs[j]) == expected);
+        }
+
+        // The inputs determine every output, so the other value of an output is inconsistent
+        std::vector<bool> values;
+        for (const var_t out : outs) values.push_back(random.value(out));
+        for (size_t j = outs.size() - 24; j < outs.size(); j++)
+        {
+            if (is_const(outs[j])) continue;
+            for (uint32_t i = 0; i < ins.size(); i++) random.assume((row >> i) & 1 ? ins[i] : -ins[i]);
+            random.assume(values[j] ? -outs[j] : outs[j]);
+            assert(Solver::state_t::STATE_UNSAT == random.check());
+        }
+        assert(random.num_pending() == 0);
+    }
+    return 0;
+}
+
+int test_deferred()
+{
+    Solver solver;
+    solver.set_deferred(true);
+    assert(solver.is_deferred());
+    std::vector<var_t> v;
+    for (uint32_t i = 0; i < 6; i++) v.push_back(solver.new_var());
+
+    // Two-level rewriting over the nodes of the inputs
+    const var_t x = solver.make_and(v[0], v[1]);
+    const var_t y = solver.make_and(v[0], -v[1]);
+    assert(solver.num_clauses() == 0 && solver.num_pending() == 2);
+    assert(solver.make_and(x, -v[0]) == var_t::ZERO);
+    assert(solver.make_and(v[1], x) == x);
+    assert(solver.make_and(x, y) == var_t::ZERO);
+    assert(solver.make_and(-x, -v[1]) == -v[1]);
+    assert(solver.make_and(-x, v[0]) == y);
+    assert(solver.make_or(x, y) == v[0]);
+    const var_t w = solver.make_and(v[0], v[2]);
+    assert(solver.make_and(x, -w) == solver.make_and(x, -v[2]));
+    assert(solver.make_and(-solver.make_and(v[2], v[1]), x) == solver.make_and(x, -v[2]));
+    assert(solver.make_and(x, -solver.make_and(-v[1], v[3])) == x);
+    assert(solver.make_and(x, solver.make_and(v[3], -v[1])) == var_t::ZERO);
+    assert(solver.make_or(solver.make_and(v[2], v[3]), solver.make_and(-v[3], v[2])) == v[2]);
+    assert(solver.make_or(solver.make_and(v[4], v[5]), solver.make_and(v[5], -v[4])) == v[5]);
+    const var_t z = solver.make_xor(v[2], v[3]);
+    assert(solver.make_xor(z, v[2]) == v[3]);
+    assert(solver.make_xor(-v[3], z) == -v[2]);
+    assert(solver.make_xor(z, solver.make_xor(-v[3], v[4])) == -solver.make_xor(v[2], v[4]));
+    assert(solver.num_clauses() == 0);
+
+    // A chain of single-use ANDs is emitted as one n-ary AND
+    const var_t c1 = solver.make_and(v[2], v[3]);
+    const var_t c2 = solver.make_and(c1, v[4]);
+    const var_t c3 = solver.make_and(c2, -v[5]);
+    solver.add_clause(c3);
+    solver.emit_deferred();
+    assert(solver.num_pending() == 0);
+    const int nc = solver.num_clauses();
+    assert(Solver::state_t::STATE_SAT == solver.check());
+    assert(solver.value(c1) && solver.value(c2) && solver.value(c3));
+    assert(solver.value(v[2]) && solver.value(v[3]) && solver.value(v[4]) && !solver.value(v[5]));
+    assert(solver.value(z) == (solver.value(v[2]) != solver.value(v[3])));
+
+    // Inlined nodes are emitted once they are referenced elsewhere
+    solver.add_clause(-c1);
+    assert(solver.num_pending() == 1);
+    assert(Solver::state_t::STATE_UNSAT == solver.check());
+    // The unit -c1 reduces the definition of c1 to (-v[2], -v[3])
+    assert(solver.num_clauses() == nc + 2);
+
+    // Nodes referenced by a clause are not inlined
+    Solver shared;
+    shared.set_deferred(true);
+    const var_t s0 = shared.new_vars(3);
+    const var_t s1 = cxxsat::as_var(as_int(s0) + 1), s2 = cxxsat::as_var(as_int(s0) + 2);
+    const var_t inner = shared.make_and(s0, s1);
+    const var_t outer = shared.make_and(inner, s2);
+    shared.add_clause(-outer);
+    shared.add_clause(inner);
+    shared.assume(-s0);
+    assert(Solver::state_t::STATE_UNSAT == shared.check());
+
+    Solver immediate, deferred;
+    deferred.set_deferred(true);
+    for (Solver* s : {&immediate, &deferred})
+    {
+        const var_t first = s->new_vars(8);
+        var_t chain = first;
+        for (int32_t i = 1; i < 8; i++) chain = s->make_and(chain, cxxsat::as_var(as_int(first) + i));
+        s->add_clause(chain);
+        assert(Solver::state_t::STATE_SAT == s->check());
+    }
+    // The unit on the output turns the inlined binary clauses into units
+    assert(immediate.num_clauses() == 1 + 7 * 3);
+    assert(deferred.num_clauses() == 1 + 8);
+    deferred.set_deferred(false);
+    assert(!deferred.is_deferred());
+
+    // A unit on an XOR output only turns into an equivalence of its inputs once the XOR
+    // is emitted, the model satisfies the clauses over the inputs in every mode
+    for (uint32_t mode = 0; mode < 4; mode++)
+    {
+        Solver s;
+        if (mode == 1) s.set_deferred(true);
+        if (mode == 2) s.set_lazy(true);
+        if (mode == 3) s.set_polarity(true);
+        const var_t xa = s.new_var(), xb = s.new_var(), xd = s.new_var();
+        const var_t xc = s.make_xor(xa, xb);
+        s.add_clause(-xb, xd);
+        s.add_clause(-xd);
+        s.add_clause(xc);
+        assert(Solver::state_t::STATE_SAT == s.check());
+        assert(s.value(xa) && !s.value(xb) && !s.value(xd) && s.value(xc));
+    }
+
+    // Random circuits evaluate as simulated, also across incremental checks
+    Solver random;
+    random.set_deferred(true);
+    return random_circuits(random, 0xdefe);
+}
+
+int test_lazy()
+{
+    Solver solver;
+    solver.set_lazy(true);
+    assert(solver.is_lazy() && solver.is_deferred());
+    std::vector<var_t> v;
+    for (uint32_t i = 0; i < 8; i++) v.push_back(solver.new_var());
+
+    const var_t a = solver.make_and(v[0], v[1]);
+    const var_t b = solver.make_xor(v[2], v[3]);
+    const var_t c = solver.make_mux(v[4], a, b);
+    const var_t d = solver.make_and(v[5], v[6]);
+    const var_t e = solver.make_xor(d, v[7]);
+    // A library of gates that no query touches
+    std::vector<var_t> helpers(v);
+    for (uint32_t i = 0; i < 64; i++)
+        helpers.push_back(solver.make_maj(helpers[i], -helpers[i + 3], helpers[i + 7]));
+    assert(solver.num_pending() == 0);
+
+    // Only the cone of c is emitted
+    solver.add_clause(solver.new_var(), c);
+    assert(solver.num_pending() == 1);
+    assert(Solver::state_t::STATE_SAT == solver.check());
+    assert(solver.num_clauses() == 1 + 6 + 3 + 4);
+    assert(solver.value(d) == (solver.value(v[5]) && solver.value(v[6])));
+    assert(solver.value(e) == (solver.value(d) != solver.value(v[7])));
+    const int maj_ins = solver.value(helpers[63]) + !solver.value(helpers[66]) + solver.value(helpers[70]);
+    assert(solver.value(helpers.back()) == (maj_ins >= 2));
+
+    // Assumptions pull in their cones, gates are emitted once across checks
+    solver.assume(e);
+    solver.assume(v[5]);
+    solver.assume(v[6]);
+    assert(Solver::state_t::STATE_SAT == solver.check());
+    assert(solver.num_clauses() == 1 + 6 + 3 + 4 + 4 + 3);
+    assert(!solver.value(v[7]) && solver.value(d));
+    solver.assume(e);
+    solver.assume(v[7]);
+    solver.assume(d);
+    assert(Solver::state_t::STATE_UNSAT == solver.check());
+    assert(solver.num_clauses() == 1 + 6 + 3 + 4 + 4 + 3);
+
+    // The unit on y makes x constant and x the inputs complementary, which only happens once the
+    // dormant XORs are emitted, so the model satisfies every user clause
+    Solver dormant;
+    dormant.set_lazy(true);
+    const var_t da = dormant.new_var(), db = dormant.new_var(), dd = dormant.new_var(), de = dormant.new_var();
+    const var_t dx = dormant.make_xor(da, db);
+    const var_t dy = dormant.make_xor(dx, de);
+    const std::vector<std::vector<var_t>> clauses = {{-db, dd}, {-dd}, {-de}, {dy}};
+    for (const auto& clause : clauses) dormant.add_clause(clause);
+    assert(dormant.num_pending() == 1);
+    assert(Solver::state_t::STATE_SAT == dormant.check());
+    for (const auto& clause : clauses)
+        assert(std::any_of(clause.begin(), clause.end(), [&](var_t x) { return dormant.value(x); }));
+    assert(dormant.value(dx) == (dormant.value(da) != dormant.value(db)));
+    assert(dormant.value(dy) == (dormant.value(dx) != dormant.value(de)));
+    assert(dormant.value(da) && !dormant.value(db));
+
+    // Stopping lazy mode keeps deferring, so later gates are emitted without references
+    solver.set_lazy(false);
+    assert(!solver.is_lazy() && solver.is_deferred());
+    solver.make_and(v[0], v[7]);
+    assert(solver.num_pending() == 1);
+    solver.set_deferred(false);
+    assert(solver.num_pending() == 0);
+    assert(solver.num_clauses() == 1 + 6 + 3 + 4 + 4 + 3 + 3);
+    return 0;
+}
+
+int test_polarity()
+{
+    Solver solver;
+    solver.set_polarity(true);
+    assert(solver.is_polarity() && solver.is_lazy() && solver.is_deferred());
+    std::vector<var_t> v;
+    for (uint32_t i = 0; i < 8; i++) v.push_back(solver.new_var());
+
+    // A positive reference only needs r -> AND(a, b), the function still gives the value
+    const var_t a = solver.make_and(v[0], v[1]);
+    const var_t w = solver.new_var();
+    solver.add_clause(w, a);
+    solver.assume(w);
+    solver.assume(v[0]);
+    solver.assume(v[1]);
+    assert(Solver::state_t::STATE_SAT == solver.check());
+    assert(solver.num_clauses() == 1 + 2);
+    assert(solver.value(a));
+
+    // A negative reference upgrades the gate with the missing half
+    solver.assume(v[0]);
+    solver.assume(v[1]);
+    solver.assume(-a);
+    assert(Solver::state_t::STATE_UNSAT == solver.check());
+    assert(solver.num_clauses() == 1 + 2 + 1);
+    solver.assume(-a);
+    assert(Solver::state_t::STATE_SAT == solver.check());
+    assert(solver.num_clauses() == 1 + 2 + 1);
+
+    // The negative half of the MUX references x negatively, while the XOR needs both polarities of b
+    const var_t b = solver.make_and(v[2], v[3]);
+    const var_t x = solver.make_xor(b, v[4]);
+    const var_t m = solver.make_mux(v[5], solver.make_and(v[6], v[7]), x);
+    solver.add_clause(-m, w);
+    assert(Solver::state_t::STATE_SAT == solver.check());
+    assert(solver.num_clauses() == 1 + 2 + 1 + 1 + 3 + 1 + 2 + 3);
+    solver.assume(-w);
+    solver.assume(-v[5]);
+    solver.assume(-v[4]);
+    assert(Solver::state_t::STATE_SAT == solver.check());
+    assert(!solver.value(m) && !solver.value(x) && !solver.value(b));
+    assert(!solver.value(v[2]) || !solver.value(v[3]));
+
+    // The cache answers XOR(x, v[4]) with b, which the function of x implies
+    assert(solver.make_xor(x, v[4]) == b);
+    solver.assume(-w);
+    solver.assume(v[5]);
+    assert(Solver::state_t::STATE_SAT == solver.check());
+    assert(!solver.value(v[6]) || !solver.value(v[7]));
+
+    // Stopping lazy mode stops polarity mode and keeps deferring
+    solver.set_lazy(false);
+    assert(!solver.is_polarity() && solver.is_deferred());
+    solver.set_polarity(true);
+    solver.set_deferred(false);
+    assert(!solver.is_polarity() && !solver.is_lazy());
+
+    Solver random;
+    random.set_polarity(true);
+    return random_circuits(random, 0x9019);
+}
+
+int test_xor_system()
+{
+    using cxxsat::XorSystem;
+    auto v = [](int32_t i) { return cxxsat::as_var(i); };
+    XorSystem system;
+    assert(system.add({v(1), v(2), v(3)}, true) == XorSystem::INDEPENDENT);
+    assert(system.add({v(2), v(3), v(4)}, false) == XorSystem::INDEPENDENT);
+    // The sum of both constraints, and its complement
+    assert(system.add({v(1), v(4)}, true) == XorSystem::REDUNDANT);
+    assert(system.add({v(4), v(1)}, false) == XorSystem::CONFLICT);
+    assert(system.add({}, false) == XorSystem::REDUNDANT);
+    assert(system.rank() == 2 && system.num_columns() == 4);
+    // Eliminating v(2) from the first constraint leaves an equivalence
+    std::vector<cxxsat::parity_t> implied = system.take_implied();
+    assert(implied.size() == 1 && implied[0].vars == std::vector<var_t>({v(1), v(4)}) && implied[0].rhs);
+    assert(system.take_implied().empty());
+    assert(system.add({v(4), v(3)}, true) == XorSystem::INDEPENDENT);
+    implied = system.take_implied();
+    assert(implied.size() == 2);
+
+    // Constraints over 200 variables span several words. All of them hold for a hidden
+    // assignment, so none conflicts, and at full rank every row is a unit of that assignment
+    std::mt19937_64 rng(0x6a55);
+    const uint32_t num_vars = 200;
+    std::vector<bool> hidden;
+    for (uint32_t i = 0; i < num_vars; i++) hidden.push_back(rng() & 1);
+    XorSystem wide;
+    std::vector<var_t> vars;
+    size_t num_independent = 0;
+    for (uint32_t round = 0; wide.rank() < num_vars || round < 2 * num_vars; round++)
+    {
+        vars.clear();
+        bool rhs = false;
+        for (uint32_t i = 0; i < num_vars; i++)
+        {
+            if (rng() % 16 != 0) continue;
+            vars.push_back(v(static_cast<int32_t>(i + 1)));
+            rhs = rhs != hidden[i];
+        }
+        const XorSystem::result_t res = wide.add(vars, rhs);
+        assert(res != XorSystem::CONFLICT);
+        if (res == XorSystem::INDEPENDENT)
+        {
+            num_independent += 1;
+            // A flipped parity of an independent constraint is a conflict from now on
+            assert(wide.add(vars, !rhs) == XorSystem::CONFLICT);
+        }
+        else if (!vars.empty()) assert(wide.add(vars, !rhs) == XorSystem::CONFLICT);
+    }
+    assert(wide.rank() == num_independent);
+    implied = wide.take_implied();
+    assert(implied.size() == num_vars);
+    for (const cxxsat::parity_t& unit : implied)
+        assert(unit.vars.size() == 1 && unit.rhs == hidden[cxxsat::as_int(unit.vars[0]) - 1]);
+    return 0;
+}
+
+int test_add_xor()
+{
+    Solver solver;
+    std::vector<var_t> v;
+    for (uint32_t i = 0; i < 8; i++) v.push_back(solver.new_var());
+    const std::vector<std::vector<var_t>> parities = {
+        {v[0], v[1], v[2]}, {v[1], -v[2], v[3]}, {v[0], v[3]}, {v[4], v[4], -v[5]}, {v[6], v[7], v[5], v[2], v[1]}};
+    for (const std::vector<var_t>& lits : parities) solver.add_xor(lits);
+    // The third constraint is the sum of the first two, the fourth is the unit -v[5]
+    assert(Solver::state_t::STATE_SAT == solver.check());
+    assert(solver.num_redundant_xors() == 1);
+    for (const std::vector<var_t>& lits : parities)
+    {
+        bool sum = false;
+        for (const var_t x : lits) sum = sum != solver.value(x);
+        assert(sum);
+    }
+    // The elimination finds v[0] == -v[3] and -v[5]
+    assert(solver.make_xor(v[0], v[3]) == var_t::ONE);
+    assert(solver.make_and(v[5], v[6]) == var_t::ZERO);
+
+    solver.add_xor({v[2], v[1], v[0]}, false);
+    assert(Solver::state_t::STATE_UNSAT == solver.check());
+    solver.add_xor({v[0], -v[0], var_t::ZERO}, true);
+    assert(solver.num_redundant_xors() == 1);
+    assert(Solver::state_t::STATE_UNSAT == solver.check());
+    return 0;
+}
+
+int test_xor_encoding()
+{
+    using cxxsat::xor_shape_t;
+    for (const xor_shape_t shape : {xor_shape_t::CHAIN, xor_shape_t::TREE})
+    {
+        for (const uint32_t width : {2u, 3u, 4u, 7u})
+        {
+            Solver solver;
+            solver.set_xor_encoding(shape, width);
+            assert(solver.xor_encoding(5) == std::make_pair(shape, width));
+            std::vector<var_t> ins;
+            for (uint32_t i = 0; i < 2; i++) ins.push_back(solver.new_var());
+            while (ins.size() < 7)
+            {
+                // Negated inputs negate the output
+                const var_t in = solver.new_var();
+                ins.push_back(ins.size() % 2 ? -in : in);
+                const var_t res = solver.make_xor(ins);
+                for (uint32_t row = 0; row < (1u << ins.size()); row++)
+                {
+                    bool expected = false;
+                    for (uint32_t i = 0; i < ins.size(); i++)
+                    {
+                        solver.assume((row >> i) & 1 ? ins[i] : -ins[i]);
+                        expected = expected != (((row >> i) & 1) != 0);
+                    }
+                    assert(Solver::state_t::STATE_SAT == solver.check());
+                    assert(solver.value(res) == expected);
+                }
+            }
+        }
+    }
+
+    // Chunks have exactly 2^k clauses for their k inputs, the short last one included
+    auto cost = [](xor_shape_t shape, uint32_t width, uint32_t num_ins) {
+        Solver solver;
+        solver.set_xor_encoding(shape, width);
+        const var_t first = solver.new_vars(static_cast<int>(num_ins));
+        std::vector<var_t> ins;
+        for (uint32_t i = 0; i < num_ins; i++) ins.push_back(cxxsat::as_var(cxxsat::as_int(first) + static_cast<int32_t>(i)));
+        solver.make_xor(ins);
+        return std::make_pair(solver.num_clauses(), solver.num_vars() - static_cast<int>(num_ins));
+    };
+    assert(cost(xor_shape_t::CHAIN, 7, 8) == std::make_pair(128 + 4, 2));
+    assert(cost(xor_shape_t::TREE, 7, 8) == std::make_pair(128 + 4, 2));
+    assert(cost(xor_shape_t::CHAIN, 3, 9) == std::make_pair(4 * 8, 4));
+    assert(cost(xor_shape_t::TREE, 3, 8) == std::make_pair(3 * 8 + 4, 4));
+    assert(cost(xor_shape_t::CHAIN, 4, 8) == std::make_pair(16 + 16 + 4, 3));
+    assert(cost(xor_shape_t::TREE, 4, 9) == std::make_pair(16 + 16 + 8, 3));
+
+    // The cost model prefers narrow chunks over the former fixed width of 7
+    Solver automatic;
+    assert(automatic.xor_encoding(3).second == 3);
+    assert(automatic.xor_encoding(16).second == 3);
+    automatic.set_xor_encoding(xor_shape_t::CHAIN);
+    assert(automatic.xor_encoding(16) == std::make_pair(xor_shape_t::CHAIN, 3u));
+    assert(cost(xor_shape_t::AUTO, 0, 16) == std::make_pair(7 * 8 + 4, 8));
+    return 0;
+}
+
 int test_at_most()
 {
     Solver solver;
@@ -431,6 +1207,234 @@ int test_at_most()
     return 0;
 }
 
+const std::vector<card_encoding_t> card_encodings = {
+    card_encoding_t::SEQUENTIAL,
+    card_encoding_t::TOTALIZER,
+    card_encoding_t::MODULO_TOTALIZER,
+    card_encoding_t::SORTING_NETWORK,
+    card_encoding_t::AUTO
+};
+
+int check_at_most_row(Solver& solver, const std::vector<var_t>& ins, uint32_t k,
+                      const std::vector<var_t>& results, uint64_t row)
+{
+    uint32_t expected = 0;
+    for (uint32_t pos_i = 0; pos_i < ins.size(); pos_i++)
+    {
+        bool pos = (row >> pos_i) & 1;
+        if (cxxsat::is_const(ins[pos_i])) pos = (ins[pos_i] == var_t::ONE);
+        solver.assume(pos ? +ins[pos_i] : -ins[pos_i]);
+        expected += pos;
+    }
+    assert(Solver::state_t::STATE_SAT == solver.check());
+    std::cout << expected << " <= " << k << " :";
+    for (var_t res : results)
+    {
+        std::cout << " " << solver.value(res);
+        assert(solver.value(res) == (expected <= k));
+    }
+    std::cout << std::endl;
+    return 0;
+}
+
+int test_at_most_encodings()
+{
+    Solver solver;
+
+    std::vector<var_t> ins;
+    std::vector<var_t> results;
+
+    ins.push_back(solver.new_var());
+    do {
+        ins.push_back(solver.new_var());
+
+        for (uint32_t k = 0; k <= ins.size() + 1; k++)
+        {
+            results.clear();
+            for (card_encoding_t encoding : card_encodings)
+                results.push_back(solver.make_at_most(ins, k, encoding));
+
+            for (uint32_t row = 0; row < (1u << ins.size()); row++)
+                assert(!check_at_most_row(solver, ins, k, results, row));
+        }
+    } while (ins.size() != MAX_VECTOR_TEST);
+
+    // Deeper trees and larger moduli are only checked on random rows
+    std::mt19937_64 rng(0x5eed);
+    while (ins.size() != 3 * MAX_VECTOR_TEST)
+        ins.push_back(solver.new_var());
+
+    for (uint32_t k = 1; k < ins.size(); k += 3)
+    {
+        results.clear();
+        for (card_encoding_t encoding : card_encodings)
+        {
+            const int nc = solver.num_clauses();
+            results.push_back(solver.make_at_most(ins, k, encoding));
+            std::cout << "encoding " << static_cast<int>(encoding) << " with k = " << k << " uses "
+                      << solver.num_clauses() - nc << " clauses" << std::endl;
+        }
+
+        for (uint32_t row = 0; row < NUM_RANDOM_ROWS; row++)
+        {
+            // Bias the rows towards sums close to the bound
+            uint64_t bits = 0;
+            for (uint32_t pos_i = 0; pos_i < ins.size(); pos_i++)
+                bits |= (uint64_t)(rng() % ins.size() < k + row % 3) << pos_i;
+            assert(!check_at_most_row(solver, ins, k, results, bits));
+        }
+    }
+
+    return 0;
+}
+
+const std::vector<amo_encoding_t> amo_encodings = {
+    amo_encoding_t::PAIRWISE,
+    amo_encoding_t::LADDER,
+    amo_encoding_t::COMMANDER,
+    amo_encoding_t::PRODUCT,
+    amo_encoding_t::BIMANDER,
+    amo_encoding_t::AUTO
+};
+
+/// Checks four results per encoding on \a row: the reified at-most-one and exactly-one,
+/// followed by the activation literals of the added at-most-one and exactly-one
+int check_amo_row(Solver& solver, const std::vector<var_t>& ins, const std::vector<var_t>& results, uint64_t row)
+{
+    uint32_t count = 0;
+    std::vector<var_t> assumed;
+    for (uint32_t pos_i = 0; pos_i < ins.size(); pos_i++)
+    {
+        bool pos = (row >> pos_i) & 1;
+        if (cxxsat::is_const(ins[pos_i])) pos = (ins[pos_i] == var_t::ONE);
+        assumed.push_back(pos ? +ins[pos_i] : -ins[pos_i]);
+        count += pos;
+    }
+    for (const var_t x : assumed) solver.assume(x);
+    assert(Solver::state_t::STATE_SAT == solver.check());
+    for (size_t i = 0; i < results.size(); i += 4)
+    {
+        assert(solver.value(results[i]) == (count <= 1));
+        assert(solver.value(results[i + 1]) == (count == 1));
+    }
+    for (size_t i = 0; i < results.size(); i += 4)
+    {
+        for (size_t j = 2; j < 4; j++)
+        {
+            for (const var_t x : assumed) solver.assume(x);
+            solver.assume(results[i + j]);
+            const bool expected = (j == 2) ? (count <= 1) : (count == 1);
+            assert(solver.check() == (expected ? Solver::state_t::STATE_SAT : Solver::state_t::STATE_UNSAT));
+        }
+    }
+    return 0;
+}
+
+int add_amo_results(Solver& solver, const std::vector<var_t>& ins, std::vector<var_t>& results)
+{
+    results.clear();
+    for (const amo_encoding_t encoding : amo_encodings)
+    {
+        results.push_back(solver.make_at_most_one(ins, encoding));
+        results.push_back(solver.make_exactly_one(ins, encoding));
+        results.push_back(solver.new_var());
+        solver.add_at_most_one(ins, encoding, results.back());
+        results.push_back(solver.new_var());
+        solver.add_exactly_one(ins, encoding, results.back());
+    }
+    return 0;
+}
+
+int test_at_most_one()
+{
+    Solver solver;
+
+    std::vector<var_t> ins;
+    std::vector<var_t> results;
+
+    // Constants and negated inputs are folded and encoded like the others
+    assert(solver.make_at_most_one(ins) == var_t::ONE);
+    assert(solver.make_exactly_one(ins) == var_t::ZERO);
+    assert(solver.make_at_most_one({var_t::ONE, var_t::ONE}) == var_t::ZERO);
+    do {
+        ins.push_back((ins.size() % 3 == 1) ? -solver.new_var() : solver.new_var());
+        assert(!add_amo_results(solver, ins, results));
+        for (uint32_t row = 0; row < (1u << ins.size()); row++)
+            assert(!check_amo_row(solver, ins, results, row));
+    } while (ins.size() != MAX_VECTOR_TEST);
+
+    ins.push_back(var_t::ONE);
+    assert(!add_amo_results(solver, ins, results));
+    for (uint32_t row = 0; row < (1u << (ins.size() - 1)); row++)
+        assert(!check_amo_row(solver, ins, results, row));
+    ins.pop_back();
+
+    // Recursive commanders and product grids need more inputs, which are checked on random rows
+    std::mt19937_64 rng(0xa70);
+    while (ins.size() != 4 * MAX_VECTOR_TEST)
+        ins.push_back(solver.new_var());
+    assert(!add_amo_results(solver, ins, results));
+    for (uint32_t row = 0; row < NUM_RANDOM_ROWS; row++)
+    {
+        // Set none, one or two of the inputs
+        uint64_t bits = 0;
+        for (uint32_t i = 0; i < row % 3; i++) bits |= uint64_t(1) << (rng() % ins.size());
+        assert(!check_amo_row(solver, ins, results, bits));
+    }
+
+    // The dedicated encodings are smaller than a general counter with bound one
+    int nc = solver.num_clauses();
+    solver.make_at_most(ins, 1, card_encoding_t::SEQUENTIAL);
+    const int sequential = solver.num_clauses() - nc;
+    nc = solver.num_clauses();
+    solver.make_at_most(ins, 1);
+    assert(solver.num_clauses() - nc < sequential);
+    nc = solver.num_clauses();
+    solver.add_at_most_one(ins);
+    assert(solver.num_clauses() - nc < 3 * static_cast<int>(ins.size()));
+
+    return 0;
+}
+
+int test_totalizer()
+{
+    Solver solver;
+
+    std::vector<var_t> ins;
+    for (uint32_t i = 0; i < MAX_VECTOR_TEST - 2; i++)
+        ins.push_back(solver.new_var());
+
+    cxxsat::Totalizer totalizer(solver, ins);
+    assert(totalizer.size() == ins.size());
+    assert(solver.num_clauses() == 0);
+
+    // Bounds are requested in an order that tightens and relaxes them
+    std::vector<uint32_t> bounds = {3, 1, 4, 0, 2, 5, 6, 7};
+    for (int round = 0; round < 2; round++)
+    {
+        for (uint32_t k : bounds)
+        {
+            var_t res = totalizer.at_most(k);
+            const int nc = solver.num_clauses();
+            assert(res == totalizer.at_most(k));
+            assert(-res == totalizer.at_least(k + 1));
+            assert(nc == solver.num_clauses());
+
+            for (uint32_t row = 0; row < (1u << ins.size()); row++)
+                assert(!check_at_most_row(solver, ins, k, {res}, row));
+        }
+
+        // Extend the totalizer with a constant and two fresh inputs
+        ins.push_back(var_t::ONE);
+        ins.push_back(solver.new_var());
+        ins.push_back(solver.new_var());
+        totalizer.add_inputs({ins.end() - 3, ins.end()});
+        assert(totalizer.size() == ins.size());
+    }
+
+    return 0;
+}
+
 int test_at_least()
 {
     Solver solver;
@@ -482,6 +1486,79 @@ int test_at_least()
     return 0;
 }
 
+int test_pb()
+{
+    Solver solver;
+
+    std::vector<var_t> ins;
+    for (uint32_t i = 0; i < MAX_VECTOR_TEST - 2; i++)
+        ins.push_back(solver.new_var());
+    // Repeated and negated inputs as well as constants have to be normalized
+    ins.push_back(-ins[1]);
+    ins.push_back(ins[2]);
+    ins.push_back(var_t::ONE);
+    const std::vector<int64_t> weights = {7, 3, 5, -2, 4, 6, 3, 1, 2};
+    assert(ins.size() == weights.size());
+
+    const std::vector<pb_encoding_t> encodings = {
+        pb_encoding_t::BDD,
+        pb_encoding_t::GENERALIZED_TOTALIZER,
+        pb_encoding_t::ADDER,
+        pb_encoding_t::AUTO
+    };
+
+    // The first inputs are the only free variables
+    const uint32_t num_free = MAX_VECTOR_TEST - 2;
+    for (int64_t bound = -3; bound <= 30; bound++)
+    {
+        std::vector<var_t> les, ges, eqs;
+        for (pb_encoding_t encoding : encodings)
+        {
+            les.push_back(solver.make_pb_le(ins, weights, bound, encoding));
+            ges.push_back(solver.make_pb_ge(ins, weights, bound, encoding));
+            eqs.push_back(solver.make_pb_eq(ins, weights, bound, encoding));
+        }
+
+        for (uint32_t row = 0; row < (1 << num_free); row++)
+        {
+            std::unordered_map<var_t, bool> assigns = {{var_t::ONE, true}, {var_t::ZERO, false}};
+            for (uint32_t pos_i = 0; pos_i < num_free; pos_i++)
+            {
+                bool pos = row & (1 << pos_i);
+                solver.assume(pos ? +ins[pos_i] : -ins[pos_i]);
+                assigns[+ins[pos_i]] = pos;
+                assigns[-ins[pos_i]] = !pos;
+            }
+            int64_t sum = 0;
+            for (uint32_t i = 0; i < ins.size(); i++)
+                sum += assigns.at(ins[i]) ? weights[i] : 0;
+
+            assert(Solver::state_t::STATE_SAT == solver.check());
+            std::cout << sum << " vs " << bound << std::endl;
+            for (uint32_t e = 0; e < encodings.size(); e++)
+            {
+                assert(solver.value(les[e]) == (sum <= bound));
+                assert(solver.value(ges[e]) == (sum >= bound));
+                assert(solver.value(eqs[e]) == (sum == bound));
+            }
+        }
+    }
+
+    // Structurally identical BDDs are shared through the MUX cache
+    const int nc = solver.num_clauses();
+    solver.make_pb_le(ins, weights, 11, pb_encoding_t::BDD);
+    assert(nc == solver.num_clauses());
+
+    // Extreme weights and bounds are normalized without overflowing
+    const int64_t max = INT64_MAX;
+    assert(solver.make_pb_ge({ins[0]}, {max}, max) == ins[0]);
+    assert(solver.make_pb_le({ins[0], ins[1]}, {max, max}, max - 1) == -solver.make_or(ins[0], ins[1]));
+    assert(solver.make_pb_le({var_t::ONE, ins[0]}, {max, 1}, -1) == var_t::ZERO);
+    assert(solver.make_pb_le({ins[0], ins[1]}, {max, -max}, 0) == solver.make_pb_le({ins[0], -ins[1]}, {1, 1}, 1));
+
+    return 0;
+}
+
 int test_add_clause()
 {
     Solver solver;
@@ -525,6 +1602,96 @@ int test_add_clause()
     return 0;
 }
 
+int test_clause_simplify()
+{
+    Solver solver;
+    const var_t a = solver.new_var();
+    const var_t b = solver.new_var();
+    const var_t c = solver.new_var();
+    std::ostringstream out;
+    solver.set_stream(&out);
+
+    // Literals are sorted by variable, repeated literals and ZERO are removed
+    solver.add_clause(c, -a, b, -a, var_t::ZERO);
+    solver.add_clause({-c, b, var_t::ZERO, b, a});
+    // Tautologies and satisfied clauses are dropped
+    solver.add_clause(a, b, -a);
+    solver.add_clause({c, -b, a, b});
+    solver.add_clause(var_t::ONE, a);
+    assert(solver.num_clauses() == 2);
+
+    // Long clauses take the general sort
+    std::vector<var_t> many;
+    for (uint32_t i = 0; i < 40; i++) many.push_back(solver.new_var());
+    std::vector<var_t> reversed(many.rbegin(), many.rend());
+    reversed.push_back(many[7]);
+    solver.add_clause(reversed);
+    solver.flush();
+    std::string expected = "-1 2 3 0\n1 2 -3 0\n";
+    for (const var_t x : many) expected += std::to_string(cxxsat::as_int(x)) + " ";
+    assert(out.str() == expected + "0\n");
+
+    // Duplicates are only rejected while the clause set is enabled
+    solver.add_clause(b, c);
+    solver.set_clause_set(true);
+    solver.add_clause(b, c);
+    solver.add_clause({c, b, c});
+    solver.add_clause(-a, b, var_t::ZERO);
+    solver.add_clause(b, -a);
+    solver.add_clause(var_t::ZERO);
+    solver.add_clause({var_t::ZERO, var_t::ZERO});
+    assert(solver.num_clauses() == 7 && solver.clause_set_size() == 3);
+    solver.set_clause_set(false);
+    assert(solver.clause_set_size() == 0);
+    solver.add_clause(b, c);
+    assert(solver.num_clauses() == 8);
+    return 0;
+}
+
+int test_add_clauses()
+{
+    Solver solver;
+
+    var_t a = solver.new_var();
+    var_t b = solver.new_var();
+    var_t c = solver.new_var();
+    const int32_t one = cxxsat::as_int(var_t::ONE), zero = cxxsat::as_int(var_t::ZERO);
+
+    std::ostringstream out;
+    solver.set_stream(&out);
+
+    // (a | b) & (-a | c), the clause with ONE is dropped and ZERO is removed
+    const std::vector<int32_t> flat = {1, 2, 0, -1, zero, 3, 0, 2, one, 0};
+    solver.add_clauses(flat.data(), flat.size());
+    assert(solver.num_clauses() == 2);
+
+    // (-b | -c) & (-c), given in CSR form
+    const std::vector<int32_t> lits = {-2, -3, -3};
+    const std::vector<size_t> offsets = {0, 2, 3};
+    solver.add_clauses(lits.data(), offsets.data(), 2);
+    assert(solver.num_clauses() == 4);
+
+    assert(out.str().empty());
+    assert(Solver::state_t::STATE_SAT == solver.check());
+    assert(out.str() == "1 2 0\n-1 3 0\n-2 -3 0\n-3 0\n");
+    assert(solver.value(b) && !solver.value(a) && !solver.value(c));
+    solver.clear_stream();
+
+    // Large batches are passed on before check
+    std::vector<int32_t> many;
+    for (uint32_t i = 0; i < cxxsat::CLAUSE_BUFFER_SIZE; i++)
+    {
+        const int32_t v = cxxsat::as_int(solver.new_var());
+        many.insert(many.end(), {v, 1, 2, 3, 0});
+    }
+    solver.add_clauses(many.data(), many.size());
+    assert(solver.num_clauses() == 4 + cxxsat::CLAUSE_BUFFER_SIZE);
+    solver.add_clauses(std::vector<int32_t>{1, 0}.data(), 2);
+    assert(Solver::state_t::STATE_UNSAT == solver.check());
+
+    return 0;
+}
+
 int test_operator()
 {
     cxxsat::solver = new Solver();
@@ -538,21 +1705,351 @@ int test_operator()
     var_t e = a ^ b;
     assert(e == cxxsat::solver->make_xor(a, b));
 
+    // Chains of the same operator become a single n-ary gate
+    var_t f = cxxsat::solver->new_var();
+    var_t g = cxxsat::solver->new_var();
+    int nv = cxxsat::solver->num_vars();
+    int nc = cxxsat::solver->num_clauses();
+    var_t h = a & -b & f & g;
+    assert(cxxsat::solver->num_vars() == nv + 1 && cxxsat::solver->num_clauses() == nc + 5);
+    assert(h == cxxsat::solver->make_and({a, -b, f, g}));
+    var_t i = a | b | f;
+    assert(i == cxxsat::solver->make_or({a, b, f}));
+    var_t j = a ^ b ^ f ^ g;
+    assert(j == cxxsat::solver->make_xor({a, b, f, g}));
+
+    // Other operators end the chain and are built first
+    var_t k = (a & b) | (f ^ g) | -(a & f);
+    assert(k == cxxsat::solver->make_or({c, cxxsat::solver->make_xor(f, g), -cxxsat::solver->make_and(a, f)}));
+    var_t m = cxxsat::mux(a, b & f & g, var_t::ZERO) & c;
+    assert(m == cxxsat::solver->make_and(cxxsat::solver->make_mux(a, cxxsat::solver->make_and({b, f, g}), var_t::ZERO), c));
+
     delete cxxsat::solver;
     return 0;
 }
 
+int test_solver_scope()
+{
+    Solver global;
+    cxxsat::solver = &global;
+    assert(cxxsat::current_solver() == &global);
+    {
+        Solver outer;
+        const cxxsat::SolverScope outer_scope(outer);
+        var_t a = outer.new_var();
+        var_t b = outer.new_var();
+        {
+            Solver inner;
+            const cxxsat::SolverScope inner_scope(inner);
+            assert(cxxsat::current_solver() == &inner);
+        }
+        assert(cxxsat::current_solver() == &outer);
+        var_t c = a & b;
+        assert(c == outer.make_and(a, b) && global.num_vars() == 0);
+    }
+    assert(cxxsat::current_solver() == &global);
+
+    // Every thread builds its formula in its own solver
+    const int num_threads = 4;
+    std::vector<int> failed(num_threads, 1);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; t++)
+    {
+        threads.emplace_back([t, &failed]() {
+            Solver local;
+            const cxxsat::SolverScope scope(local);
+            const var_t first = local.new_vars(8);
+            std::vector<var_t> ins;
+            for (int32_t i = 0; i < 8; i++) ins.push_back(cxxsat::as_var(cxxsat::as_int(first) + i));
+            for (int round = 0; round < 100; round++)
+            {
+                var_t p = ins[0] ^ ins[1] ^ ins[2] ^ ins[3];
+                var_t q = (ins[4] & ins[5] & -ins[6]) | cxxsat::mux(ins[7], p, -p);
+                if (p != local.make_xor({ins[0], ins[1], ins[2], ins[3]})) return;
+                local.add_clause(q);
+            }
+            local.assume(ins[t % 8]);
+            failed[t] = (local.check() != Solver::state_t::STATE_SAT) || (cxxsat::current_solver() != &local);
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    for (int t = 0; t < num_threads; t++) assert(!failed[t]);
+    assert(global.num_vars() == 0 && cxxsat::current_solver() == &global);
+
+    cxxsat::solver = nullptr;
+    return 0;
+}
+
+/// Builds a small formula through every traced call and returns the number of calls
+uint32_t build_traced(Solver& solver)
+{
+    const var_t a = solver.new_var();
+    const var_t first = solver.new_vars(5);
+    std::vector<var_t> ins = {a};
+    for (int32_t i = 0; i < 5; i++) ins.push_back(cxxsat::as_var(cxxsat::as_int(first) + i));
+
+    const var_t g = solver.make_and(ins[0], -ins[1]);
+    const var_t h = solver.make_or(g, ins[2]);
+    const var_t x = solver.make_xor(h, ins[3]);
+    const var_t m = solver.make_mux(x, ins[4], var_t::ONE);
+    const var_t t = solver.make_xor3(m, ins[5], -g);
+    const var_t j = solver.make_maj(t, ins[0], ins[2]);
+    const var_t an = solver.make_and({j, ins[1], -ins[3]});
+    const var_t on = solver.make_or({an, ins[4], var_t::ZERO});
+    const var_t xn = solver.make_xor({on, ins[5], ins[0], ins[2]});
+    const var_t am = solver.make_at_most(ins, 2, card_encoding_t::TOTALIZER);
+    const var_t al = solver.make_at_least(ins, 2);
+    const var_t pb = solver.make_pb_le(ins, {3, -2, 5, 1, 1, 4}, 6);
+    const var_t pg = solver.make_pb_ge(ins, {1, 2, 3, 4, 5, 6}, 7, pb_encoding_t::ADDER);
+    const var_t pe = solver.make_pb_eq(ins, {1, 1, 2, 2, 3, 3}, 4);
+    const var_t ao = solver.make_at_most_one(ins, amo_encoding_t::PRODUCT);
+    const var_t eo = solver.make_exactly_one({ins[1], -ins[2], ins[3]});
+    solver.add_clause(am, al);
+    solver.add_clause({pb, pg, -pe, xn});
+    solver.add_xor({g, ins[4], -xn}, false);
+    solver.add_at_most_one(ins, amo_encoding_t::LADDER, ao);
+    solver.add_exactly_one({g, h, x}, amo_encoding_t::AUTO, eo);
+    const int32_t lits[] = {cxxsat::as_int(a), -cxxsat::as_int(first), 0};
+    solver.add_clauses(lits, 3);
+    solver.assume(-ins[5]);
+    solver.check();
+    solver.assume(var_t::ZERO);
+    solver.check();
+    solver.add_clause(ins[1]);
+    return 29;
+}
+
+int test_trace()
+{
+    const std::string path = "unit-solver-trace.bin";
+    std::ostringstream recorded, replayed;
+    Solver solver;
+    cxxsat::TraceWriter trace(path);
+    solver.set_trace(&trace);
+    solver.set_stream(&recorded);
+    const uint32_t num_calls = build_traced(solver);
+    solver.flush();
+    solver.clear_trace();
+    // Nested calls of the builders are not traced
+    assert(trace.num_ops() == num_calls);
+    trace.close();
+
+    Solver replay;
+    replay.set_stream(&replayed);
+    const std::vector<cxxsat::trace_phase_t> phases = cxxsat::replay_trace(replay, path);
+    replay.flush();
+    assert(replayed.str() == recorded.str() && !recorded.str().empty());
+    assert(replay.num_vars() == solver.num_vars() && replay.num_clauses() == solver.num_clauses());
+
+    // Encoding phases alternate with the checks
+    assert(phases.size() == 5);
+    assert(!phases[0].solve && phases[0].num_ops == num_calls - 4);
+    assert(phases[1].solve && phases[1].state == Solver::state_t::STATE_SAT);
+    assert(!phases[2].solve && phases[2].num_ops == 1);
+    assert(phases[3].solve && phases[3].state == Solver::state_t::STATE_UNSAT);
+    assert(!phases[4].solve && phases[4].num_ops == 1);
+
+    // Malformed traces are rejected
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << "CXTR\x01\x02\x03";
+    }
+    Solver broken;
+    bool thrown = false;
+    try { cxxsat::replay_trace(broken, path); }
+    catch (const std::runtime_error&) { thrown = true; }
+    assert(thrown);
+    return 0;
+}
+
+/// Evaluates the outputs of the binary AIGER file \a text for the given input values
+std::vector<bool> simulate_aiger(const std::string& text, const std::vector<bool>& inputs)
+{
+    std::istringstream in(text);
+    std::string magic;
+    uint32_t m, i, l, o, a;
+    in >> magic >> m >> i >> l >> o >> a;
+    assert(magic == "aig" && m == i + a && l == 0 && inputs.size() == i);
+    std::vector<uint32_t> outs(o);
+    for (uint32_t& out : outs) in >> out;
+    in.get();
+
+    std::vector<bool> values(m + 1, false);
+    for (uint32_t k = 0; k < i; k++) values[k + 1] = inputs[k];
+    auto value = [&](uint32_t lit) { return values[lit / 2] != bool(lit & 1); };
+    auto varint = [&]() {
+        uint32_t x = 0, shift = 0;
+        int c;
+        while ((c = in.get()) & 0x80) { x |= uint32_t(c & 0x7f) << shift; shift += 7; }
+        return x | (uint32_t(c) << shift);
+    };
+    for (uint32_t k = 0; k < a; k++)
+    {
+        const uint32_t lhs = 2 * (i + k + 1);
+        const uint32_t rhs0 = lhs - varint();
+        const uint32_t rhs1 = rhs0 - varint();
+        assert(rhs0 < lhs && rhs1 <= rhs0);
+        values[lhs / 2] = value(rhs0) && value(rhs1);
+    }
+    std::vector<bool> res;
+    for (const uint32_t out : outs) res.push_back(value(out));
+    return res;
+}
+
+int test_aiger()
+{
+    Solver solver;
+    std::vector<var_t> ins;
+    for (uint32_t i = 0; i < 6; i++) ins.push_back(solver.new_var());
+
+    const var_t g = solver.make_or(ins[0], -ins[1]);
+    const var_t x = solver.make_xor(g, ins[2]);
+    const var_t m = solver.make_mux(x, ins[3], -ins[4]);
+    const var_t t = solver.make_xor3(m, ins[5], -g);
+    const var_t j = solver.make_maj(t, -ins[0], ins[2]);
+    const var_t an = solver.make_and({j, ins[1], -ins[3], x});
+    const var_t xn = solver.make_xor({an, ins[5], -ins[0], ins[4]});
+    const std::vector<var_t> outputs = {xn, -m, t, var_t::ONE};
+
+    const std::string path = "unit-solver-circuit.aig";
+    const cxxsat::aiger_info_t info = cxxsat::write_aiger(solver, path, outputs);
+    assert(info.inputs == ins && info.outputs == outputs);
+    std::ifstream file(path, std::ios::binary);
+    const std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    assert(text.find("i0 1\ni1 2\n") != std::string::npos);
+
+    // Every input assignment gives the same outputs as the solver
+    for (uint32_t row = 0; row < (1u << ins.size()); row++)
+    {
+        std::vector<bool> values;
+        for (uint32_t i = 0; i < ins.size(); i++)
+        {
+            values.push_back((row >> i) & 1);
+            solver.assume(values.back() ? ins[i] : -ins[i]);
+        }
+        assert(Solver::state_t::STATE_SAT == solver.check());
+        const std::vector<bool> sim = simulate_aiger(text, values);
+        for (size_t k = 0; k < outputs.size(); k++) assert(sim[k] == solver.value(outputs[k]));
+    }
+
+    // By default the cone of all gates is exported through the unused gate outputs
+    const cxxsat::aiger_info_t all = cxxsat::write_aiger(solver, path);
+    assert(all.outputs == std::vector<var_t>{cxxsat::abs_var_t(xn)});
+    assert(all.inputs == ins && all.num_ands == info.num_ands);
+    return 0;
+}
+
+int test_gate_table()
+{
+    cxxsat::GateTable<binary_key_t> table;
+    assert(table.find({var_t::ONE, var_t::ONE}) == table.end());
+
+    const int32_t n = 10000;
+    for (int32_t i = 1; i <= n; i++)
+        assert(table.emplace({cxxsat::as_var(-i), cxxsat::as_var(i + 1)}, cxxsat::as_var(i)).second);
+    assert(table.size() == n);
+    assert(table.load_factor() <= 0.875);
+
+    // Existing entries are kept, like std::unordered_map::emplace
+    auto dup = table.emplace({cxxsat::as_var(-7), cxxsat::as_var(8)}, var_t::ONE);
+    assert(!dup.second && dup.first->second == cxxsat::as_var(7));
+
+    for (int32_t i = 1; i <= n; i++)
+    {
+        auto it = table.find({cxxsat::as_var(-i), cxxsat::as_var(i + 1)});
+        assert(it != table.end() && it->second == cxxsat::as_var(i));
+        assert(table.find({cxxsat::as_var(i), cxxsat::as_var(i + 1)}) == table.end());
+    }
+
+    int64_t sum = 0;
+    size_t count = 0;
+    for (const auto& entry : table) { sum += cxxsat::as_int(entry.second); count++; }
+    assert(count == n && sum == int64_t(n) * (n + 1) / 2);
+
+    table.clear();
+    assert(table.empty() && table.begin() == table.end());
+    return 0;
+}
+
+int test_stats()
+{
+    using cxxsat::gate_kind_t;
+    Solver solver;
+
+    var_t a = solver.new_var();
+    var_t b = solver.new_var();
+    var_t c = solver.new_var();
+
+    var_t x = solver.make_and(a, b);
+    assert(solver.make_or(-a, -b) == -x);
+    assert(solver.make_and(a, var_t::ONE) == a);
+    solver.make_xor(a, b);
+    solver.make_mux(a, b, c);
+    solver.make_mux(a, var_t::ONE, c);
+
+    cxxsat::solver_stats_t stats = solver.stats();
+    assert(stats[gate_kind_t::AND].lookups == 3);
+    assert(stats[gate_kind_t::AND].hits == 1);
+    assert(stats[gate_kind_t::AND].folds == 1);
+    assert(stats[gate_kind_t::AND].inserts == 2);
+    assert(stats[gate_kind_t::AND].clauses == 6 && stats[gate_kind_t::AND].vars == 2);
+    assert(stats[gate_kind_t::XOR].inserts == 1 && stats[gate_kind_t::XOR].clauses == 4);
+    assert(stats[gate_kind_t::MUX].lookups == 1 && stats[gate_kind_t::MUX].folds == 1);
+    assert(stats[gate_kind_t::MUX].clauses == 6);
+    assert(stats.and_table.size == 2 && stats.and_table.mean_probe >= 1.0);
+    assert(stats.xor_table.size == 3);
+
+    std::vector<var_t> ins;
+    for (uint32_t i = 0; i < 6; i++) ins.push_back(solver.new_var());
+    const uint32_t nc = solver.num_clauses();
+    solver.make_at_most(ins, 2, card_encoding_t::TOTALIZER);
+    solver.make_at_most(ins, 6);
+    stats = solver.stats();
+    assert(stats[gate_kind_t::CARD].folds == 1);
+    assert(stats[gate_kind_t::CARD].clauses == solver.num_clauses() - nc);
+
+    std::ostringstream json;
+    stats.write_json(json);
+    assert(json.str().find("\"and\": {\"lookups\": 3, \"hits\": 1, \"folds\": 1") != std::string::npos);
+    assert(json.str().find("\"tables\": {\"and\": {\"size\": 2") != std::string::npos);
+    return 0;
+}
+
 const std::map<const std::string, test_func_t> tests = {
     {"test_and", test_and},
     {"test_or", test_or},
     {"test_xor", test_xor},
     {"test_mux", test_mux},
+    {"test_xor3", test_xor3},
+    {"test_maj", test_maj},
     {"test_and_multi", test_and_multi},
     {"test_or_multi", test_or_multi},
+    {"test_xor_multi", test_xor_multi},
+    {"test_nary_cache", test_nary_cache},
+    {"test_detect_gates", test_detect_gates},
+    {"test_substitution", test_substitution},
+    {"test_harvest_fixed", test_harvest_fixed},
+    {"test_deferred", test_deferred},
+    {"test_lazy", test_lazy},
+    {"test_polarity", test_polarity},
+    {"test_xor_system", test_xor_system},
+    {"test_add_xor", test_add_xor},
+    {"test_xor_encoding", test_xor_encoding},
     {"test_at_most", test_at_most},
+    {"test_at_most_encodings", test_at_most_encodings},
+    {"test_at_most_one", test_at_most_one},
+    {"test_totalizer", test_totalizer},
     {"test_at_least", test_at_least},
+    {"test_pb", test_pb},
     {"test_add_clause", test_add_clause},
-    {"test_operator", test_operator}
+    {"test_clause_simplify", test_clause_simplify},
+    {"test_add_clauses", test_add_clauses},
+    {"test_trace", test_trace},
+    {"test_aiger", test_aiger},
+    {"test_gate_table", test_gate_table},
+    {"test_stats", test_stats},
+    {"test_operator", test_operator},
+    {"test_solver_scope", test_solver_scope}
 };
 
 int main(int argc, const char* argv[])
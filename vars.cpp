@@ -1,10 +1,29 @@
 #include "vars.h"
 #include "Solver.h"
+#include <vector>
 
 using var_t = cxxsat::var_t;
 
-var_t cxxsat::operator&(var_t x, var_t y) { return cxxsat::solver->make_and(x, y); }
-var_t cxxsat::operator|(var_t x, var_t y) { return cxxsat::solver->make_or(x, y); }
-var_t cxxsat::operator^(var_t x, var_t y) { return cxxsat::solver->make_xor(x, y); }
+var_t cxxsat::build_expr(expr_op_t op, const var_t* ins, size_t num)
+{
+    Solver* const target = current_solver();
+    // Two inputs use the binary gates, which the n-ary builders would fold into anyway
+    if (num == 2)
+    {
+        switch (op)
+        {
+            case expr_op_t::AND: return target->make_and(ins[0], ins[1]);
+            case expr_op_t::OR:  return target->make_or(ins[0], ins[1]);
+            default:             return target->make_xor(ins[0], ins[1]);
+        }
+    }
+    const std::vector<var_t> actual(ins, ins + num);
+    switch (op)
+    {
+        case expr_op_t::AND: return target->make_and(actual);
+        case expr_op_t::OR:  return target->make_or(actual);
+        default:             return target->make_xor(actual);
+    }
+}
 
-var_t cxxsat::mux(var_t s, var_t t, var_t e) { return cxxsat::solver->make_mux(s, t, e); }
+var_t cxxsat::build_mux(var_t s, var_t t, var_t e) { return current_solver()->make_mux(s, t, e); }
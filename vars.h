@@ -3,6 +3,9 @@
 
 #include "debug.h"
 #include <cstdint>
+#include <cstddef>
+#include <array>
+#include <type_traits>
 
 namespace cxxsat {
 
@@ -16,12 +19,79 @@ inline constexpr var_t operator-(var_t x) { return as_var(-as_int(x)); }
 inline constexpr var_t operator!(var_t x) { return -x; }
 inline constexpr var_t operator+(var_t x) { return x; }
 
+/// Operations of the expression nodes built by the operators below
+enum class expr_op_t {AND, OR, XOR};
 
-var_t operator&(var_t x, var_t y);
-var_t operator|(var_t x, var_t y);
-var_t operator^(var_t x, var_t y);
+/// Creates the gate of \a op over \a num inputs in cxxsat::current_solver()
+var_t build_expr(expr_op_t op, const var_t* ins, size_t num);
+/// Creates MUX(s, t, e) in cxxsat::current_solver()
+var_t build_mux(var_t s, var_t t, var_t e);
 
-var_t mux(var_t s, var_t t, var_t e);
+/// Flattens an operand of \a Op into leaves. Operands of other operations become single leaves,
+/// converted to var_t when the expression is
+template<expr_op_t Op, typename E>
+struct expr_leaves {
+    static constexpr size_t size = 1;
+    static void collect(const E& e, var_t*& out) { *out++ = e; }
+};
+
+/// Chain of the same operation, converted into a single n-ary gate over all of its leaves
+template<expr_op_t Op, typename L, typename R>
+struct nary_expr {
+    L lhs;
+    R rhs;
+
+    operator var_t() const
+    {
+        std::array<var_t, expr_leaves<Op, nary_expr>::size> leaves;
+        var_t* out = leaves.data();
+        expr_leaves<Op, nary_expr>::collect(*this, out);
+        return build_expr(Op, leaves.data(), leaves.size());
+    }
+};
+
+template<expr_op_t Op, typename L, typename R>
+struct expr_leaves<Op, nary_expr<Op, L, R>> {
+    static constexpr size_t size = expr_leaves<Op, L>::size + expr_leaves<Op, R>::size;
+    static void collect(const nary_expr<Op, L, R>& e, var_t*& out)
+    {
+        expr_leaves<Op, L>::collect(e.lhs, out);
+        expr_leaves<Op, R>::collect(e.rhs, out);
+    }
+};
+
+template<typename L, typename R> using and_expr = nary_expr<expr_op_t::AND, L, R>;
+template<typename L, typename R> using or_expr = nary_expr<expr_op_t::OR, L, R>;
+template<typename L, typename R> using xor_expr = nary_expr<expr_op_t::XOR, L, R>;
+
+template<typename S, typename T, typename E>
+struct mux_expr {
+    S s;
+    T t;
+    E e;
+
+    operator var_t() const { return build_mux(s, t, e); }
+};
+
+/// True for var_t and the expression nodes
+template<typename T> struct is_expr : std::false_type {};
+template<> struct is_expr<var_t> : std::true_type {};
+template<expr_op_t Op, typename L, typename R> struct is_expr<nary_expr<Op, L, R>> : std::true_type {};
+template<typename S, typename T, typename E> struct is_expr<mux_expr<S, T, E>> : std::true_type {};
+template<typename... Ts> using enable_if_expr = std::enable_if_t<(is_expr<Ts>::value && ...)>;
+
+// The operators return expression nodes that only create gates in the current solver once converted
+// to var_t, so a & b & c becomes one AND over three inputs. An expression kept in an auto
+// variable is built again on every conversion
+template<typename L, typename R, typename = enable_if_expr<L, R>>
+inline and_expr<L, R> operator&(const L& x, const R& y) { return {x, y}; }
+template<typename L, typename R, typename = enable_if_expr<L, R>>
+inline or_expr<L, R> operator|(const L& x, const R& y) { return {x, y}; }
+template<typename L, typename R, typename = enable_if_expr<L, R>>
+inline xor_expr<L, R> operator^(const L& x, const R& y) { return {x, y}; }
+
+template<typename S, typename T, typename E, typename = enable_if_expr<S, T, E>>
+inline mux_expr<S, T, E> mux(const S& s, const T& t, const E& e) { return {s, t, e}; }
 
 inline constexpr bool is_negated(var_t x) { return as_int(x) < 0; }
 inline constexpr var_t abs_var_t(var_t x) { return is_negated(x) ? -x : +x; }